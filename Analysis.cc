@@ -14,6 +14,11 @@
 #include <assert.h>
 #include "MemAdvise.h"
 #include "Stats.h"
+#include "Options.h"
+#include "CFGExport.h"
+#include "Trace.h"
+
+extern Options options;
 
 // an inline function to test whether a given node has a back edge
 bool HasABackEdge(CFGNode* curNode) 
@@ -27,10 +32,35 @@ bool HasABackEdge(CFGNode* curNode)
 //********************************************************************************
 // Conditional structuring routines
 //********************************************************************************
+void StructCond(CFGNode* curNode)
+// Pre: curNode has more than one out edge and the conditional headers below it have
+//		  been structured
+{
+	// if the current conditional header is a two way node and has a back edge, 
+	// then it won't have a follow
+	if (HasABackEdge(curNode) && curNode->GetType() == cBranch)
+	{
+		curNode->SetStructType(Cond);
+		return;
+	}
+
+	// set the follow of a node to be its immediate post dominator
+	curNode->SetCondFollow(curNode->GetImmPDom());
+
+	// set the structured type of this node
+	curNode->SetStructType(Cond);
+
+	// if this is an nway header, then we have to tag each of the nodes
+	// within the body of the nway subgraph
+	if (curNode->GetCondType() == Case)
+		curNode->SetCaseHead(curNode,curNode->GetCondFollow());
+}
+
 void Graphs::StructConds(ProcHeader* curProc)
 // Structures all conditional headers (i.e. nodes with more than one outedge)
 {
 	NodePtrArr const &order = curProc->Ordering;
+	bool const* done = curProc->preStructured;	// nodes structured by StructRegions
 
 	// Process the nodes in order
 	for (int i = 0; i < order.Size(); i++)
@@ -38,27 +68,8 @@ void Graphs::StructConds(ProcHeader* curProc)
 		CFGNode* curNode = order[i];
 
 		// does the current node have more than one out edge?
-		if (curNode->GetOutEdges().Size() > 1)
-		{
-			// if the current conditional header is a two way node and has a back edge, 
-			// then it won't have a follow
-			if (HasABackEdge(curNode) && curNode->GetType() == cBranch)
-			{
-				curNode->SetStructType(Cond);
-				continue;
-			}
-		
-			// set the follow of a node to be its immediate post dominator
-			curNode->SetCondFollow(curNode->GetImmPDom());
-
-			// set the structured type of this node
-			curNode->SetStructType(Cond);
-
-			// if this is an nway header, then we have to tag each of the nodes
-			// within the body of the nway subgraph
-			if (curNode->GetCondType() == Case)
-				curNode->SetCaseHead(curNode,curNode->GetCondFollow());
-		}
+		if (curNode->GetOutEdges().Size() > 1 && !(done && done[i]))
+			StructCond(curNode);
 	}
 
 }
@@ -66,11 +77,7 @@ void Graphs::StructConds(ProcHeader* curProc)
 //********************************************************************************
 // Loop structuring routines
 //********************************************************************************
-#ifndef INTERVALS
-void DetermineLoopType(CFGNode* header, bool* &loopNodes)
-#else
-void DetermineLoopType(CFGNode* header)
-#endif
+void DetermineLoopType(CFGNode* header, bool* &loopNodes, structurer alg)
 // Pre: The loop induced by (head,latch) has already had all its member nodes tagged
 // Post: The type of loop has been deduced
 {
@@ -90,35 +97,38 @@ void DetermineLoopType(CFGNode* header)
 	// otherwise it is either a pretested or endless loop
 	else if (header->GetType() == cBranch)
 	{
-	#ifndef INTERVALS
-		// if the header is a two way node then it must have a conditional follow (since it
-		// can't have any backedges leading from it). If this follow is within the loop then
-		// this must be an endless loop
-		assert(header->GetCondFollow());
-		if (loopNodes[header->GetCondFollow()->Order()])
+		if (alg == Parens)
 		{
-			header->SetLoopType(Endless);
+			// if the header is a two way node then it will have a conditional follow unless
+			// one of its edges is a back edge to an enclosing loop (i.e. a jump back to the
+			// enclosing header that comes out of splitting an irreducible graph). If there is
+			// no follow or the follow is within the loop then this must be an endless loop
+			if (!header->GetCondFollow() || loopNodes[header->GetCondFollow()->Order()])
+			{
+				header->SetLoopType(Endless);
 
-			// retain the fact that this is also a conditional header
-			header->SetStructType(LoopCond);
+				// retain the fact that this is also a conditional header
+				header->SetStructType(LoopCond);
+			}
+			else
+				header->SetLoopType(PreTested);
 		}
 		else
-		header->SetLoopType(PreTested);
-	#else
-		// if the header is a two way conditional header, then it will be a pretested loop
-		// if one of its children is its conditional follow
-		if (header->GetOutEdges()[0] != header->GetCondFollow() && header->GetOutEdges()[1] != header->GetCondFollow())
 		{
-			// neither children are the conditional follow
-			header->SetLoopType(Endless);
+			// if the header is a two way conditional header, then it will be a pretested loop
+			// if one of its children is its conditional follow
+			if (header->GetOutEdges()[0] != header->GetCondFollow() && header->GetOutEdges()[1] != header->GetCondFollow())
+			{
+				// neither children are the conditional follow
+				header->SetLoopType(Endless);
 
-			// retain the fact that this is also a conditional header
-			header->SetStructType(LoopCond);
+				// retain the fact that this is also a conditional header
+				header->SetStructType(LoopCond);
+			}
+			else
+				// one child is the conditional follow
+				header->SetLoopType(PreTested);
 		}
-		else
-			// one child is the conditional follow
-			header->SetLoopType(PreTested);
-	#endif
 	}
 
 	// both the header and latch node are one way nodes so this must be an endless loop
@@ -126,7 +136,7 @@ void DetermineLoopType(CFGNode* header)
 		header->SetLoopType(Endless);
 }
 
-void FindLoopFollow(CFGNode* header, NodePtrArr const &order, bool* &loopNodes)
+void FindLoopFollow(CFGNode* header, NodePtrArr const &order, bool* &loopNodes, structurer alg)
 // Pre: The loop headed by header has been induced and all it's member nodes have been tagged
 // Post: The follow of the loop has been determined.
 {
@@ -136,22 +146,25 @@ void FindLoopFollow(CFGNode* header, NodePtrArr const &order, bool* &loopNodes)
 
 	if (lType == PreTested)
 	{
-	#ifndef INTERVALS
-		// if the 'while' loop's true child is within the loop, then its false child is
-		// the loop follow
-		if (loopNodes[header->GetOutEdges()[0]->Order()])
-			header->SetLoopFollow(header->GetOutEdges()[1]);
+		if (alg == Parens)
+		{
+			// if the 'while' loop's true child is within the loop, then its false child is
+			// the loop follow
+			if (loopNodes[header->GetOutEdges()[0]->Order()])
+				header->SetLoopFollow(header->GetOutEdges()[1]);
 
-		// otherwise the true child is the loop follow
-		else
-			header->SetLoopFollow(header->GetOutEdges()[0]);
-	#else
-		// the child that is the loop header's conditional follow will be the loop follow
-		if (header->GetOutEdges()[0] == header->GetCondFollow())
-			header->SetLoopFollow(header->GetOutEdges()[0]);
+			// otherwise the true child is the loop follow
+			else
+				header->SetLoopFollow(header->GetOutEdges()[0]);
+		}
 		else
-			header->SetLoopFollow(header->GetOutEdges()[1]);
-	#endif
+		{
+			// the child that is the loop header's conditional follow will be the loop follow
+			if (header->GetOutEdges()[0] == header->GetCondFollow())
+				header->SetLoopFollow(header->GetOutEdges()[0]);
+			else
+				header->SetLoopFollow(header->GetOutEdges()[1]);
+		}
 	}
 	else if (lType == PostTested)
 	{
@@ -169,7 +182,7 @@ void FindLoopFollow(CFGNode* header, NodePtrArr const &order, bool* &loopNodes)
 		// traverse the ordering array between the header and latch nodes.
 		CFGNode const* latch = header->GetLatchNode();
 		for (int i = header->Order() - 1; i > latch->Order(); i--)
-		#ifndef INTERVALS
+		if (alg == Parens)
 		{
 			CFGNode* &desc = order[i];
 			// the follow for an endless loop will have the following properties:
@@ -209,7 +222,7 @@ void FindLoopFollow(CFGNode* header, NodePtrArr const &order, bool* &loopNodes)
 				}
 			}
 		} 
-		#else
+		else
 		{
 			// using intervals, the follow is determined to be the child outside the loop of a
 			// 2 way conditional header that is inside the loop such that it (the child) has
@@ -228,7 +241,6 @@ void FindLoopFollow(CFGNode* header, NodePtrArr const &order, bool* &loopNodes)
 				}
 			}
 		}
-		#endif
 
 		// if a follow was found, assign it to be the follow of the loop under investigation
 		if (follow)
@@ -236,15 +248,34 @@ void FindLoopFollow(CFGNode* header, NodePtrArr const &order, bool* &loopNodes)
 	}
 }
 
-#ifndef INTERVALS
+void LoopMembers(StampCols const &cols, int header, int latch, bool* loopNodes)
+// Pre: header and latch are the orders of a loop header and its latching node
+// Post: loopNodes[i] is set for each order i in [latch,header) such that the node is within
+//       the loop. This is the batched form of CFGNode::InLoop. The containment tests are
+//       evaluated without branches over the stamp columns so that the compiler can
+//       vectorize the sweep.
+{
+	int const* in = cols.loopIn;
+	int const* out = cols.loopOut;
+	int const* rIn = cols.revIn;
+	int const* rOut = cols.revOut;
+
+	int hIn = in[header], hOut = out[header], lIn = in[latch], lOut = out[latch];
+	int hRIn = rIn[header], hROut = rOut[header], lRIn = rIn[latch], lROut = rOut[latch];
+
+	for (int i = latch; i < header; i++)
+		loopNodes[i] = ((i == latch) |
+			((hIn < in[i]) & (out[i] < hOut) & (in[i] < lIn) & (lOut < out[i])) |
+			((hRIn < rIn[i]) & (rOut[i] < hROut) & (rIn[i] < lRIn) & (lROut < rOut[i]))) != 0;
+}
 
-void TagNodesInLoop(CFGNode* header, NodePtrArr const &order, bool* &loopNodes)
+void TagNodesInLoop(CFGNode* header, NodePtrArr const &order, StampCols const &cols, bool* &loopNodes)
 // Pre: header has been detected as a loop header and has the details of the latching node
 // Post: the nodes within the loop have been tagged
 {
 	assert(header->GetLatchNode());
 
-	// traverse the ordering structure from the header to the latch node tagging the nodes
+	// sweep the ordering structure from the header to the latch node marking the nodes
 	// determined to be within the loop. These are nodes that satisfy the following:
 	//  i) header.loopStamps encloses curNode.loopStamps and curNode.loopStamps encloses latch.loopStamps
 	//  OR
@@ -252,12 +283,13 @@ void TagNodesInLoop(CFGNode* header, NodePtrArr const &order, bool* &loopNodes)
 	//	OR
 	//  iii) curNode is the latch node
 	CFGNode const* latch = header->GetLatchNode();
+	LoopMembers(cols, header->Order(), latch->Order(), loopNodes);
+
+	// tag the members found by the sweep
 	for (int i = header->Order() - 1; i >= latch->Order(); i--)
-		if (order[i]->InLoop(header,latch))
+		if (loopNodes[i])
 		{
-			// update the membership map to reflect that this node is within the loop
-			loopNodes[i] = true;
-
+			assert(order[i]->InLoop(header,latch));
 			order[i]->SetLoopHead(header);
 		}
 #ifdef LOOPHEAD
@@ -270,8 +302,6 @@ void TagNodesInLoop(CFGNode* header, NodePtrArr const &order, bool* &loopNodes)
 
 }
 
-#else  // using intervals and derived sequences
-
 void TagNodesInLoop(CFGNode* header, NodePtrArr const& order, bool* &intNodes, bool* &loopNodes)
 // Pre: header has been detected as a loop header and has the details of the latching node
 // Post: the nodes within the loop have been tagged (if they weren't already within a more
@@ -294,14 +324,47 @@ void TagNodesInLoop(CFGNode* header, NodePtrArr const& order, bool* &intNodes, b
 		}
 	}
 }
-#endif
 
 
-void Graphs::StructLoops(ProcHeader* curProc)
+void Graphs::StructLoops(ProcHeader* curProc, structurer alg)
 // Pre: The graph for curProc has been built.
 // Post: Each node is tagged with the header of the most nested loop of which it is a member (possibly none).
 // 		  The header of each loop stores information on the latching node as well as the type of loop it heads.
-#ifndef INTERVALS
+{
+	if (alg == Parens)
+		StructParenLoops(curProc);
+	else
+		StructIntervalLoops(curProc);
+
+#ifdef TESTLOOPS
+	cerr << "\nLoop info for procedure " << curProc->name << endl;
+   cerr << "Node\t| LoopHead" << endl;
+	NodePtrArr const &order = curProc->Ordering;
+   for (int i = 0; i < order.Size(); i++)
+   {
+      CFGNode* curNode = order[i];
+		cerr << curNode->Order() << "\t|  ";
+		if (curNode->GetLoopHead())
+		{
+			cerr << curNode->GetLoopHead()->Order();
+			if (curNode->GetLatchNode())
+			{
+				cerr << "  (loop header) Type: " << curNode->GetLoopType() << ", Follow: ";
+				if (curNode->GetLoopFollow())
+					cerr << curNode->GetLoopFollow()->Order();
+				else
+					cerr << "(no follow)";
+			}
+			cerr << endl;
+		}
+		else
+			cerr << "-" << endl;
+   }
+#endif
+}
+
+void Graphs::StructParenLoops(ProcHeader* curProc)
+// Pre: the reverse loop stamps have been set
 {
 	// Process the nodes in order so that nesting is detected correctly.
 	NodePtrArr const &order = curProc->Ordering;
@@ -354,19 +417,22 @@ void Graphs::StructLoops(ProcHeader* curProc)
 			curNode->SetStructType(Loop);
 
 			// tag the members of this loop
-			TagNodesInLoop(curNode,curProc->Ordering, loopNodes);
+			TagNodesInLoop(curNode,curProc->Ordering, curProc->stamps, loopNodes);
 
 			// calculate the type of this loop
-			DetermineLoopType(curNode, loopNodes);
+			DetermineLoopType(curNode, loopNodes, Parens);
 
 			// calculate the follow node of this loop
-			FindLoopFollow(curNode,curProc->Ordering, loopNodes);
+			FindLoopFollow(curNode,curProc->Ordering, loopNodes, Parens);
 
 			// delete the space taken by the loopnodes map
 			delete[] loopNodes;
 		}
 	}
-#else
+}
+
+void Graphs::StructIntervalLoops(ProcHeader* curProc)
+// Pre: the derived sequence has been built
 {
 	// process the derived graphs of the current procedure
 	for (int gLevel = 0; gLevel < curProc->derivedGraphs.Size(); gLevel++)
@@ -374,24 +440,25 @@ void Graphs::StructLoops(ProcHeader* curProc)
 		DerivedGraph* curGraph = curProc->derivedGraphs[gLevel];
 		
 		// process each of the intervals in the current derived graph
-		for (int j = 0; j < curGraph->intervals.Size(); j++)
+		for (int j = 0; j < curGraph->numOfInts; j++)
 		{
-			IntNode* curInt = static_cast<IntNode*>(curGraph->intervals[j]);
 			CFGNode* latch = NULL;
 			
-			// find the G0 basic block node at the head of this interval
-			CFGNode* headNode = curInt;
-			for (int k = 0; k <= gLevel; k++)
-				headNode = static_cast<IntNode*>(headNode)->Nodes()[0];
+			// find the G0 basic block node at the head of this interval by following the
+			// first member of each interval down to the first graph
+			int head = j;
+			for (int k = gLevel; k >= 0; k--)
+				head = curProc->derivedGraphs[k]->members[curProc->derivedGraphs[k]->intStart[head]];
+			CFGNode* headNode = curProc->Ordering[head];
 
 			// find the cfg nodes that belong in the current interval.
 			bool* cfgNodes = new bool[curProc->size];
 			for (int i = 0; i < curProc->size; i++)
 				cfgNodes[i] = false;
 
-			curInt->FindNodesInInt(cfgNodes,gLevel);
+			FindNodesInInt(curProc, gLevel, j, cfgNodes);
 #ifdef TESTINTS
-			cerr << "BB nodes in interval " << curInt->Ident() << ": ";
+			cerr << "BB nodes in interval " << j << ": ";
 			for (int h = 0; h < curProc->size; h++)
 				if (cfgNodes[h])
 					cerr << h << ", ";
@@ -450,10 +517,10 @@ void Graphs::StructLoops(ProcHeader* curProc)
 					TagNodesInLoop(headNode,curProc->Ordering, cfgNodes,loopNodes);
 
 					// calculate the type of this loop
-					DetermineLoopType(headNode);
+					DetermineLoopType(headNode, loopNodes, Intervals);
 
 					// calculate the follow node of this loop
-					FindLoopFollow(headNode,curProc->Ordering, loopNodes);
+					FindLoopFollow(headNode,curProc->Ordering, loopNodes, Intervals);
 
 					// delete the space taken by the loopnodes map
 					delete[] loopNodes;
@@ -461,33 +528,6 @@ void Graphs::StructLoops(ProcHeader* curProc)
 			delete[] cfgNodes;
 		}
 	}
-#endif
-
-#ifdef TESTLOOPS
-	cerr << "\nLoop info for procedure " << curProc->name << endl;
-   cerr << "Node\t| LoopHead" << endl;
-	NodePtrArr const &order = curProc->Ordering;
-   for (int i = 0; i < order.Size(); i++)
-   {
-      CFGNode* curNode = order[i];
-		cerr << curNode->Order() << "\t|  ";
-		if (curNode->GetLoopHead())
-		{
-			cerr << curNode->GetLoopHead()->Order();
-			if (curNode->GetLatchNode())
-			{
-				cerr << "  (loop header) Type: " << curNode->GetLoopType() << ", Follow: ";
-				if (curNode->GetLoopFollow())
-					cerr << curNode->GetLoopFollow()->Order();
-				else
-					cerr << "(no follow)";
-			}
-			cerr << endl;
-		}
-		else
-			cerr << "-" << endl;
-   }
-#endif
 }
 
 //********************************************************************************
@@ -599,31 +639,138 @@ void Graphs::CheckConds(ProcHeader* curProc)
 	}
 }
 //********************************************************************************
-// Complete structuring routine
+// Complete structuring routines
 //********************************************************************************
-void Graphs::Structure()
+void Graphs::StructureProc(ProcHeader* curProc, structurer alg)
+// Pre: if alg is Intervals then the derived sequence for curProc has been built
+{
+	if (alg == Parens)
+		SetRevTimeStamps(curProc);
+
+	if (curProc->cls == StraightLine)
+	{
+		// there is nothing to structure and each node is post dominated by its
+		// only child
+		for (int i = 0; i < curProc->Ordering.Size(); i++)
+		{
+			CFGNode* curNode = curProc->Ordering[i];
+			if (curNode->GetOutEdges().Size() == 1)
+				curNode->SetImmPDom(curNode->GetOutEdges()[0]);
+		}
+	}
+	else
+	{
+		double start = TraceBegin();
+		StructRegions(curProc);
+		TraceEnd("StructRegions", curProc->name, start);
+
+		start = TraceBegin();
+		FindImmedPDom(curProc);
+		TraceEnd("FindImmedPDom", curProc->name, start);
+
+		start = TraceBegin();
+		StructConds(curProc);
+		TraceEnd("StructConds", curProc->name, start);
+
+		// there are no loops to find in an acyclic graph
+		if (curProc->cls != Acyclic)
+		{
+			start = TraceBegin();
+			StructLoops(curProc, alg);
+			TraceEnd("StructLoops", curProc->name, start);
+		}
+
+		start = TraceBegin();
+		CheckConds(curProc);
+		TraceEnd("CheckConds", curProc->name, start);
+	}
+
+	delete[] curProc->preStructured;
+	curProc->preStructured = NULL;
+}
+
+void Graphs::Structure(char* fname)
 {
+	// the writers of the forms the graphs are exported in
+	CFGWriter* writers[2];
+	int numWriters = 0;
+	if (options.exportFormats & CSRExport)
+		writers[numWriters++] = new CSRWriter(fname);
+	if (options.exportFormats & JSONLExport)
+		writers[numWriters++] = new JSONLWriter(fname);
+
 #ifdef GETSTATS
 	double t[3] = {0,0,0};
+	double exportTime = 0.0;	// the processor time and wall clock time taken by the
+	double exportCPU = 0.0;		// export, which aren't counted in the structuring
+	double exportWall = 0.0;
 	dtime(t);
-	stats.structMemCost  = MemStats[2];
-	stats.structMemAlloc = MemStats[0];
+	stats.structMemCost  = MemInUse();
+	stats.structMemAlloc = MemAllocated();
 #endif
 
 	ProcHeader* curProc;
 
 	for (curProc = procs; curProc; curProc = curProc->next)
 	{
-		FindImmedPDom(curProc);
-		StructConds(curProc);
-		StructLoops(curProc);
-		CheckConds(curProc);
+		ProcMark mark;
+#ifdef GETSTATS
+		double pt[3] = {0,0,0};
+		dtime(pt);
+		StartProcPhase(mark);
+#endif
+		if (options.diffStruct)
+			DiffStructure(curProc);
+		else
+			StructureProc(curProc, options.structAlg);
+#ifdef GETSTATS
+		EndProcPhase(curProc, StructurePhase, mark);
+		dtime(pt);
+		stats.classTime[curProc->cls] += pt[1];
+#endif
+
+		// write the procedure out as soon as it has been structured. The export is
+		// measured as a phase of its own for the procedure.
+		if (numWriters > 0)
+		{
+#ifdef GETSTATS
+			double et[3] = {0,0,0};
+			double cpu = CPUTime();
+			dtime(et);
+#endif
+			SetMemPhase(ExportPhase);
+			StartProcPhase(mark);
+			for (int i = 0; i < numWriters; i++)
+				writers[i]->WriteProc(curProc->name, curProc->cls, curProc->Ordering,
+					curProc->cfg, curProc->exitNode);
+			EndProcPhase(curProc, ExportPhase, mark);
+			SetMemPhase(StructurePhase);
+#ifdef GETSTATS
+			dtime(et);
+			exportTime += et[1];
+			exportCPU += CPUTime() - cpu;
+			exportWall += curProc->phaseTime[ExportPhase];
+#endif
+		}
+	}
+
+	for (int i = 0; i < numWriters; i++)
+	{
+		writers[i]->Finish();
+		delete writers[i];
 	}
 
 #ifdef GETSTATS
 	dtime(t);
-	stats.structTime = t[1];
-	stats.structMemCost  = MemStats[2] - stats.structMemCost;
-	stats.structMemAlloc = MemStats[0] - stats.structMemAlloc;
+	stats.structTime = t[1] - exportTime;
+	stats.structMemCost  = MemInUse() - stats.structMemCost;
+	stats.structMemAlloc = MemAllocated() - stats.structMemAlloc;
+
+	// the Structure phase ends after this returns so the time of the export is
+	// moved from it to the Export phase now
+	stats.phaseWall[StructurePhase] -= exportWall;
+	stats.phaseWall[ExportPhase] += exportWall;
+	stats.phaseCPU[StructurePhase] -= exportCPU;
+	stats.phaseCPU[ExportPhase] += exportCPU;
 #endif
 }
@@ -21,12 +21,13 @@
 #include "Options.h"
 #include "Stats.h"
 #include "MemAdvise.h"
+#include "Trace.h"
+#include "StringFunctions.h"
 
 // define global variables to store the command line options and
 // the runtime statistics
 Options options;
 Stats stats;
-int MemStats[3] = {0,0,0};
 
 main(int argc, char *argv[])
 {
@@ -34,81 +35,168 @@ main(int argc, char *argv[])
 	Graphs cfgs;
 	char* filename;
 
+	// the time before the first phase is counted as other
+	StartPhase(OtherPhase);
+
 	// extract the command line arguments
 	filename = options.InitArgs(argc, argv);
 
+	// the hardware events are counted from here on where they are available
+	if (options.perfCounters && !PerfOpen())
+		cerr << "Warning: the hardware performance counters are not available." << endl;
+
+	// the spans of the phases are written from here on
+	if (options.traceFile)
+		TraceOpen(options.traceFile);
+
 	//Read in the assembly source and transform it into an array
 	//of instructions
+	StartPhase(ParsePhase);
 	assCode.Build(filename);
 
 	//Build the list of basic blocks from these instructions
+	StartPhase(BuildNodesPhase);
 	cfgs.BuildNodes(assCode);
 
 	//Add the graph edges to these basic blocks
+	StartPhase(DefineEdgesPhase);
 	cfgs.DefineEdges();
 
 	//Build the list of CFG's information nodes for each procedure
+	StartPhase(DefineCfgsPhase);
 	cfgs.DefineCfgs();
 
+	//Split the nodes of irreducible CFG's if required
+	if (options.splitNodes)
+	{
+		StartPhase(SplitNodesPhase);
+		cfgs.SplitNodes();
+	}
+
 	//Do the dfs labelling of each node
+	StartPhase(SetTimeStampsPhase);
 	cfgs.SetTimeStamps();
 
-#ifdef INTERVALS
-	// Build the sequence of derived graphs for each CFG
-	cfgs.BuildDerivedSequences();
+	// Build the sequence of derived graphs for each CFG if the interval
+	// structurer is to be used
+	if (options.structAlg == Intervals || options.diffStruct)
+	{
+		StartPhase(DerSeqPhase);
+		cfgs.BuildDerivedSequences();
+
+		// Display the sequence of derived graphs for each CFG
+//		cfgs.DisplayDerivedSequences();
+	}
 
-	// Display the sequence of derived graphs for each CFG
-//	cfgs.DisplayDerivedSequences();
-#endif
+	//Classify the CFG's so that each only goes through the structuring
+	//phases it needs
+	StartPhase(ClassifyPhase);
+	cfgs.Classify();
 
 	//Apply the structuring algorithm to the CFG's of the program
-	cfgs.Structure();
+	StartPhase(StructurePhase);
+	cfgs.Structure(filename);
+
+	if (options.diffStruct)
+	{
+		//Display the differences between the structuring algorithms
+		StartPhase(OtherPhase);
+		cfgs.DisplayDiffs();
+	}
 
 	if (options.genCode)
 	{
 		//Generate HLL code
+		StartPhase(CodeGenPhase);
 		cfgs.CodeGen(filename);
 	}
 
 	if (options.genDotty)
+	{
 		//Generate the graphviz input file
+		StartPhase(GraphvizPhase);
 		cfgs.GenerateGraphvizFile(filename);
+	}
+	StartPhase(OtherPhase);
+	if (tracing)
+		TraceClose();
 
 #ifdef GETSTATS
 	// display the relevant stats
 	// Note: the graphs stats are for all the cfgs within a program and are
 	// gathered for the graphs after the unreachable nodes have been removed.
 	cout << filename << ":";
-#ifdef INTERVALS
-	cout << "(derived sequence algorithm)" << endl;
-#else
-	cout << "(parenthesis theory algorithm)" << endl;
-#endif 
+	if (options.structAlg == Intervals)
+		cout << "(derived sequence algorithm)" << endl;
+	else
+		cout << "(parenthesis theory algorithm)" << endl;
 	cout << "\t# assembly instructions in input = " << stats.numAsmIns << endl;
 	cout << "\t# unreachable instructions = " << stats.numUnreachIns << endl;
 	cout << "\t# graph nodes = " << stats.numGraphNodes << endl;
 	cout << "\t# graph edges = " << stats.numGraphEdges << endl;
-#ifdef INTERVALS
-	cout << "\t# intervals = " << stats.numIntervals << endl;
-	cout << "\t# derived graphs = " << stats.numDerGraphs << endl;
-	cout << "\t time to build derived sequences (DS) = " << stats.bldDerSeqTime << endl;
-#else
-#endif
+	if (options.structAlg == Intervals || options.diffStruct)
+	{
+		cout << "\t# intervals = " << stats.numIntervals << endl;
+		cout << "\t# derived graphs = " << stats.numDerGraphs << endl;
+		cout << "\t time to build derived sequences (DS) = " << stats.bldDerSeqTime << endl;
+	}
+	if (options.splitNodes)
+		cfgs.DisplaySplits();
+	for (int c = 0; c < NUM_GRAPH_CLASSES; c++)
+		cout << "\t # " << GraphClass2String((graphClass)c) << " CFG's = " << stats.numClass[c] << endl;
+	cout << "\t time to classify CFG's = " << stats.classifyTime << endl;
+	for (int c = 0; c < NUM_GRAPH_CLASSES; c++)
+		cout << "\t time to structure " << GraphClass2String((graphClass)c) << " CFG's = " << stats.classTime[c] << endl;
 	cout << "\t time to structure CFG's = " << stats.structTime << endl;
-#ifdef INTERVALS
-	cout << "\t memory for DS = " << stats.derSeqMemCost << endl;
-//	cout << "\t memory used building DS = " << stats.derSeqMemAlloc << endl;
-#endif
+	if (options.numThreads > 1)
+	{
+		cout << "\t # threads = " << options.numThreads << endl;
+		cout << "\t # regions in program structure trees = " << stats.numRegions << endl;
+		cout << "\t time to build program structure trees = " << stats.pstTime << endl;
+		cout << "\t # regions structured by threads = " << stats.numParRegions << endl;
+		cout << "\t # nodes in these regions = " << stats.numParNodes << endl;
+	}
+	if (options.structAlg == Intervals || options.diffStruct)
+	{
+		cout << "\t memory for DS = " << stats.derSeqMemCost << endl;
+//		cout << "\t memory used building DS = " << stats.derSeqMemAlloc << endl;
+	}
 //	cout << "\t memory added by structuring = " << stats.structMemCost << endl;
 //	cout << "\t memory used while structuring = " << stats.structMemAlloc << endl;
 	if (options.genCode)
 	{
 		cout << "\t time to generate HLL code = " << stats.codeGenTime << endl;
 		cout << "\t number of goto's generated = " << stats.numGotos << endl;
+		if (options.removeGotos)
+			cout << "\t number of goto's removed = " << stats.numGotosRemoved << endl;
 		cout << "\t number of loops's generated = " << stats.numLoops << endl;
 		cout << "\t number of if-then-{else}'s generated = " << stats.num2ways << endl;
 		cout << "\t number of switch's generated = " << stats.numNways << endl;
 		cout << "\t number of loop continue or break statements generated = " << stats.numContBrks << endl;
 	}
+	cout << "\t memory allocated = " << MemAllocated() << endl;
+	cout << "\t memory freed = " << MemFreed() << endl;
+	cout << "\t memory still in use = " << MemInUse() << endl;
+	for (int p = 0; p < NUM_PHASES; p++)
+		cout << "\t " << PhaseName[p] << ": wall time = " << stats.phaseWall[p] <<
+			", cpu time = " << stats.phaseCPU[p] << ", memory allocated = " <<
+			MemPhaseBytes((toolPhase)p) << " in " << MemPhaseAllocs((toolPhase)p) <<
+			" allocations" << endl;
+	cout << "\t peak resident set size = " << MemPeakRSS() << "K" << endl;
+	if (options.perfCounters)
+		DisplayPhasePerf();
+
+	if (options.procStats != NoProcStats)
+	{
+		cfgs.WriteProcStats(filename);
+		cfgs.DisplaySlowest(options.procTop);
+	}
+
+	if (options.statsJSON)
+	{
+		char* name = concatstr(filename, ".stats.json");
+		WriteStatsJSON(name, filename);
+		delete[] name;
+	}
 #endif
 }
@@ -0,0 +1,353 @@
+/*
+ * Copyright (C) 1997, Doug Simon
+ *
+ * See the file "LICENSE.TERMS" for information on usage and
+ * redistribution of this file, and for a DISCLAIMER OF ALL
+ * WARRANTIES.
+ *
+ */
+
+//File: AstBench.cc
+//Author: Doug Simon
+//Purpose: microbenchmarks of the data structures and analysis kernels the tool spends
+//	its time in, each measured on its own so that a change to one of them can be
+//	compared before and after. The analysis kernels are run over the graphs of each
+//	input file given (as written by astgen) and the rest over generated data.
+//
+//	Each benchmark is repeated and written to cout as one line of the form
+//
+//	{"bench":name,"input":file,"size":n,"reps":n,"best":t,"median":t,"nsPerItem":t}
+//
+//	where size is the number of items (elements, lookups or nodes) handled in each
+//	repetition, best and median are the wall clock times of a repetition in seconds
+//	and nsPerItem is the best time per item in nanoseconds. input is only given for
+//	the analysis kernels.
+
+#include <iostream.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include "Graphs.h"
+#include "Source.h"
+#include "Options.h"
+#include "Stats.h"
+#include "TypeDefs.h"
+
+#define DEFAULT_REPS 5			// the default number of repetitions of each benchmark
+#define NUM_LOOKUPS 65536		// the number of opcodes looked up by String2Type
+
+// the options and stats read by the tool's modules
+Options options;
+Stats stats;
+
+// the sizes the dynamic arrays are measured at: from the edges of a node up to the
+// ordering of a large procedure
+static int const arrSizes[] = { 8, 64, 512, 4096 };
+
+// the sizes the label arrays are measured at
+static int const labelSizes[] = { 1024, 65536 };
+
+#define NUM_SIZES(a) (int)(sizeof(a) / sizeof(a[0]))
+
+// return a pseudo random number in [0, n) that only depends on the calls before it
+static int Random(int n)
+{
+	static unsigned long seed = 1;
+	seed = seed * 1103515245 + 12345;
+	return (int)((seed >> 16) % n);
+}
+
+static int CompareTimes(const void* t1, const void* t2)
+{
+	double d = *(double const*)t1 - *(double const*)t2;
+	return (d < 0 ? -1 : (d > 0 ? 1 : 0));
+}
+
+// write out the result of a benchmark that took times[r] in repetition r
+static void Report(char const* name, char const* input, long size, double* times, int reps)
+{
+	qsort(times, reps, sizeof(double), CompareTimes);
+	double best = times[0];
+	double median = times[reps / 2];
+
+	cout << "{\"bench\":\"" << name << '"';
+	if (input)
+		cout << ",\"input\":\"" << input << '"';
+	cout << ",\"size\":" << size << ",\"reps\":" << reps << ",\"best\":" << best <<
+		",\"median\":" << median << ",\"nsPerItem\":" << (size ? best * 1.0e9 / size : 0.0) <<
+		'}' << endl;
+}
+
+//*********************************************************************
+// The dynamic array. The elements are distinct pointers that are never followed.
+//*********************************************************************
+static void BenchDynArr(int reps)
+{
+	double* times[4];
+	int k, r, i;
+
+	for (k = 0; k < 4; k++)
+		times[k] = new double[reps];
+
+	for (int s = 0; s < NUM_SIZES(arrSizes); s++)
+	{
+		int n = arrSizes[s];
+		char* elems = new char[n];
+
+		for (r = 0; r < reps; r++)
+		{
+			StrArr arr;
+			double start = WallTime();
+			for (i = 0; i < n; i++)
+				arr.Add(elems + i);
+			times[0][r] = WallTime() - start;
+
+			// every element is looked for once
+			int found = 0;
+			start = WallTime();
+			for (i = 0; i < n; i++)
+				if (arr.IsIn(elems + (i * 7) % n))
+					found++;
+			times[1][r] = WallTime() - start;
+			assert(found == n);
+
+			start = WallTime();
+			for (i = 0; i < n; i++)
+				arr.Remove(elems + i);
+			times[2][r] = WallTime() - start;
+
+			for (i = 0; i < n; i++)
+				arr.Add(elems + i);
+			start = WallTime();
+			for (i = 0; i < n; i++)
+				arr.RemoveFirst();
+			times[3][r] = WallTime() - start;
+		}
+		Report("DynArr::Add", NULL, n, times[0], reps);
+		Report("DynArr::IsIn", NULL, n, times[1], reps);
+		Report("DynArr::Remove", NULL, n, times[2], reps);
+		Report("DynArr::RemoveFirst", NULL, n, times[3], reps);
+		delete[] elems;
+	}
+
+	for (k = 0; k < 4; k++)
+		delete[] times[k];
+}
+
+//*********************************************************************
+// The opcode lookup of each instruction parsed. Every opcode is looked up in turn
+// (other than "invalid", which no instruction has).
+//*********************************************************************
+static void BenchString2Type(int reps)
+{
+	double* times = new double[reps];
+	int numOpcodes = (int)iInvalid;
+	char const** ops = new char const*[numOpcodes];
+	int i;
+
+	for (i = 0; i < numOpcodes; i++)
+		ops[i] = Type2String((iType)i);
+
+	for (int r = 0; r < reps; r++)
+	{
+		int sum = 0;
+		double start = WallTime();
+		for (i = 0; i < NUM_LOOKUPS; i++)
+			sum += String2Type(ops[i % numOpcodes]);
+		times[r] = WallTime() - start;
+
+		// keep the lookups from being optimised away
+		if (sum < 0)
+			cerr << sum << endl;
+	}
+	Report("String2Type", NULL, NUM_LOOKUPS, times, reps);
+
+	delete[] ops;
+	delete[] times;
+}
+
+//*********************************************************************
+// The labels of the source. They are added in a shuffled order as the labels of
+// generated code are, sorted and then each is found once.
+//*********************************************************************
+static void BenchLabelArr(int reps)
+{
+	double* sortTimes = new double[reps];
+	double* findTimes = new double[reps];
+
+	for (int s = 0; s < NUM_SIZES(labelSizes); s++)
+	{
+		int n = labelSizes[s];
+		char** names = new char*[n];
+		int i;
+
+		for (i = 0; i < n; i++)
+		{
+			char name[32];
+			sprintf(name, ".LL%d", i);
+			names[i] = new char[strlen(name) + 1];
+			strcpy(names[i], name);
+		}
+		for (i = n - 1; i > 0; i--)
+		{
+			int j = Random(i + 1);
+			char* tmp = names[i];
+			names[i] = names[j];
+			names[j] = tmp;
+		}
+
+		for (int r = 0; r < reps; r++)
+		{
+			LabelArr labels(n);
+			for (i = 0; i < n; i++)
+				labels.Add(names[i], i);
+
+			double start = WallTime();
+			labels.Sort();
+			sortTimes[r] = WallTime() - start;
+
+			start = WallTime();
+			for (i = 0; i < n; i++)
+				if (labels.Find(names[(i * 7) % n]) != (i * 7) % n)
+				{
+					cerr << "Error: label " << names[(i * 7) % n] << " was not found." << endl;
+					exit(1);
+				}
+			findTimes[r] = WallTime() - start;
+		}
+		Report("LabelArr::Sort", NULL, n, sortTimes, reps);
+		Report("LabelArr::Find", NULL, n, findTimes, reps);
+
+		for (i = 0; i < n; i++)
+			delete[] names[i];
+		delete[] names;
+	}
+
+	delete[] sortTimes;
+	delete[] findTimes;
+}
+
+//*********************************************************************
+// The analysis kernels. The graphs are built from the source again for each
+// repetition and taken through the phases of the tool as far as code generation,
+// each kernel being timed by the phase hooks of the tool for each procedure.
+//*********************************************************************
+#ifndef GETSTATS
+#error the analysis kernels are timed by the phases measured for each procedure (GETSTATS)
+#endif
+
+class KernelBench {
+public:
+	static void Run(Source const &src, char* input, int reps);
+
+private:
+	enum kernel { Stamps, Class, Struct, Code, NUM_KERNELS };
+
+	// take the graphs through the phases once, adding the time of each kernel to
+	// times and returning the number of nodes they ran over
+	static long Rep(Source const &src, char* input, double* times);
+};
+
+void KernelBench::Run(Source const &src, char* input, int reps)
+{
+	static char const* names[NUM_KERNELS] = { "Graphs::SetTimeStamps",
+		"Graphs::Classify", "Graphs::Structure", "Graphs::CodeGen" };
+	double* times[NUM_KERNELS];
+	double repTimes[NUM_KERNELS];
+	long size = 0;
+	int k;
+
+	for (k = 0; k < NUM_KERNELS; k++)
+		times[k] = new double[reps];
+
+	for (int r = 0; r < reps; r++)
+	{
+		size = Rep(src, input, repTimes);
+		for (k = 0; k < NUM_KERNELS; k++)
+			times[k][r] = repTimes[k];
+	}
+
+	for (k = 0; k < NUM_KERNELS; k++)
+	{
+		Report(names[k], input, size, times[k], reps);
+		delete[] times[k];
+	}
+}
+
+long KernelBench::Rep(Source const &src, char* input, double* times)
+{
+	static toolPhase const phases[NUM_KERNELS] = { SetTimeStampsPhase, ClassifyPhase,
+		StructurePhase, CodeGenPhase };
+	Graphs* cfgs = new Graphs;
+	Graphs::ProcHeader* curProc;
+	long size = 0;
+
+	cfgs->BuildNodes(src);
+	cfgs->DefineEdges();
+	cfgs->DefineCfgs();
+	cfgs->SetTimeStamps();
+	cfgs->Classify();
+	cfgs->Structure(input);
+	cfgs->CodeGen(input);
+
+	for (int k = 0; k < NUM_KERNELS; k++)
+		times[k] = 0.0;
+	for (curProc = cfgs->procs; curProc; curProc = curProc->next)
+	{
+		for (int k = 0; k < NUM_KERNELS; k++)
+			times[k] += curProc->phaseTime[phases[k]];
+		size += curProc->size;
+	}
+
+	// free the graphs so that each repetition starts on the same heap
+	delete cfgs;
+	return size;
+}
+
+static void Usage(char const* progname)
+{
+	cerr << "usage: " << progname << " [-r reps] [file ...]" << endl;
+	cerr << endl;
+	cerr << "\tTime the dynamic arrays, opcode lookups and label arrays and then the" << endl;
+	cerr << "\tanalysis kernels on the graphs of each file" << endl;
+	cerr << endl;
+	cerr << "\t-r repeat each benchmark reps times (default " << DEFAULT_REPS << ")" << endl;
+	exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+	char* progname = *argv;
+	int reps = DEFAULT_REPS;
+
+	while (--argc > 0 && (*++argv)[0] == '-')
+	{
+		if (strcmp(argv[0], "-r") == 0 && argc > 1)
+		{
+			reps = atoi(*++argv);
+			argc--;
+		}
+		else
+			Usage(progname);
+	}
+	if (reps < 1)
+		Usage(progname);
+
+	// the kernels are run as the tool runs them by default but nothing is written out
+	options.structAlg = Parens;
+	options.numThreads = 1;
+	options.codeFormats = 0;
+	options.exportFormats = 0;
+
+	BenchDynArr(reps);
+	BenchString2Type(reps);
+	BenchLabelArr(reps);
+
+	for (; argc > 0; argc--, argv++)
+	{
+		Source src;
+		src.Build(*argv);
+		KernelBench::Run(src, *argv, reps);
+	}
+	return 0;
+}
@@ -0,0 +1,543 @@
+/*
+ * Copyright (C) 1997, Doug Simon
+ *
+ * See the file "LICENSE.TERMS" for information on usage and
+ * redistribution of this file, and for a DISCLAIMER OF ALL
+ * WARRANTIES.
+ *
+ */
+
+//File: AstGen.cc
+//Author: Doug Simon
+//Purpose: generates synthetic SPARC assembly programs in the form read by
+//	Source::Build, so that each phase of the tool can be measured on graphs of any
+//	size and shape. The procedures are built from loops, if-else's, if-else ladders,
+//	jmp switch tables, irreducible regions and chains of calls, in the proportions
+//	given by the chosen shape. The same seed always gives the same program.
+//
+//	The file is generated twice with the same sequence of random numbers: first to
+//	count the instructions and labels that head it and then to write it out, so that
+//	programs of millions of blocks never have to be held in memory.
+
+#include <iostream.h>
+#include <fstream.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DEFAULT_BLOCKS 1000		// the default number of blocks in the program
+#define DEFAULT_PROC_BLOCKS 100	// the default number of blocks in each procedure
+#define DEFAULT_DEPTH 8				// the default deepest nesting of the statements
+#define DEFAULT_SEED 1				// the default seed of the random numbers
+#define MAX_LINE 64					// the longest line other than a jmp
+
+// the shapes of the generated procedures
+enum genShape {
+	LoopsShape,				// deeply nested while and repeat loops
+	LadderShape,			// long if-else if-...-else ladders
+	SwitchShape,			// wide jmp switch tables
+	IrreducibleShape,		// loops entered in the middle as well as at the top
+	CallsShape,				// long chains of blocks split by calls
+	MixedShape,				// a mix of all of these, with many small procedures and
+								// a few large ones
+	NUM_SHAPES
+};
+
+static char const* ShapeName[NUM_SHAPES] = { "loops", "ladder", "switch", "irreducible",
+	"calls", "mixed" };
+
+// the statements procedures are built from
+enum construct {
+	StraightCon, CallsCon, WhileCon, RepeatCon, IfCon, LadderCon, SwitchCon,
+	IrreducibleCon, NUM_CONSTRUCTS
+};
+
+// how often each statement is chosen (out of 100) for each shape
+static int const weights[NUM_SHAPES][NUM_CONSTRUCTS] = {
+	// straight calls while repeat if ladder switch irreducible
+	{ 10, 0, 45, 45, 0, 0, 0, 0 },			// loops
+	{ 10, 0, 0, 0, 0, 90, 0, 0 },			// ladder
+	{ 10, 0, 0, 0, 0, 0, 90, 0 },			// switch
+	{ 20, 0, 10, 0, 10, 0, 0, 60 },		// irreducible
+	{ 10, 90, 0, 0, 0, 0, 0, 0 },			// calls
+	{ 30, 15, 12, 6, 25, 4, 4, 4 }			// mixed
+};
+
+// the most arms of a ladder, cases of a switch and calls of a chain for each shape
+static int const maxWidth[NUM_SHAPES] = { 4, 64, 256, 4, 32, 8 };
+
+// the conditional branches used
+static char const* branches[] = { "be", "bne", "bg", "ble", "bge", "bl", "bgu", "bleu" };
+
+#define NUM_BRANCHES (int)(sizeof(branches) / sizeof(branches[0]))
+
+class Generator {
+public:
+	// width is the most arms of a ladder, cases of a switch and calls of a chain (or 0
+	// for those of the shape)
+	Generator(genShape s, long seed, int depth, int width);
+
+	// generate numProcs procedures of about procBlocks blocks each, writing them to
+	// out (or only counting them if out is NULL)
+	void Generate(int numProcs, int procBlocks, ostream* out);
+
+	long NumIns() const { return numIns; }
+	long NumLabels() const { return numLabels; }
+	long NumBlocks() const { return numBlocks; }
+	int MaxLen() const { return maxLen; }
+
+private:
+	// return a random number in [0, n)
+	long Random(long n);
+
+	// return a new label
+	char const* NewLabel();
+
+	// add a line of code or a label to the program
+	void Ins(char const* line);
+	void Label(char const* label);
+
+	// add a compare and a random conditional branch to label
+	void Branch(char const* label);
+
+	// add an unconditional branch to label
+	void Goto(char const* label);
+
+	// add statements of about budget blocks nested depth deep and return the number
+	// of blocks they took
+	long Body(int depth, long budget);
+
+	// return the number of arms of a ladder or cases of a switch that fit in budget
+	// blocks
+	int Width(long budget);
+
+	// add one statement of each kind with about budget blocks in its bodies
+	void Straight();
+	void Calls(long budget);
+	void While(int depth, long budget);
+	void Repeat(int depth, long budget);
+	void If(int depth, long budget);
+	void Ladder(int depth, long budget);
+	void Switch(int depth, long budget);
+	void Irreducible(int depth, long budget);
+
+	genShape shape;
+	long initSeed;
+	int maxDepth;
+	int width;
+
+	long state;				// the state of the random numbers
+	long nextLabel;		// the number of the next label
+	char labelText[32];	// the text of the last label made
+	ostream* out;			// where the program is written (NULL when counting)
+	bool blockOpen;		// has code been added since the last block ended?
+	long numIns;
+	long numLabels;
+	long numBlocks;
+	int maxLen;
+};
+
+Generator::Generator(genShape s, long seed, int depth, int w) :
+	shape(s), initSeed(seed), maxDepth(depth), width(w ? w : maxWidth[s])
+{
+}
+
+long Generator::Random(long n)
+// the minimal standard generator of Park and Miller, computed without overflow
+// with Schrage's method
+{
+	long hi = state / 127773;
+	long lo = state % 127773;
+	state = 16807 * lo - 2836 * hi;
+	if (state <= 0)
+		state += 2147483647;
+	return state % n;
+}
+
+char const* Generator::NewLabel()
+{
+	sprintf(labelText, ".LL%ld", nextLabel++);
+	return labelText;
+}
+
+void Generator::Ins(char const* line)
+{
+	int len = strlen(line) + 2;
+	if (len > maxLen)
+		maxLen = len;
+	if (out)
+		*out << '\t' << line << '\n';
+	numIns++;
+	blockOpen = true;
+}
+
+void Generator::Label(char const* label)
+// a label ends the block of the code before it
+{
+	if (out)
+		*out << label << ":\n";
+	numLabels++;
+	if (blockOpen)
+		numBlocks++;
+	blockOpen = false;
+}
+
+void Generator::Branch(char const* label)
+{
+	char line[MAX_LINE];
+	sprintf(line, "cmp %%o%ld,%ld", Random(6), Random(10));
+	Ins(line);
+	sprintf(line, "%s %s", branches[Random(NUM_BRANCHES)], label);
+	Ins(line);
+	Ins("nop");
+	numBlocks++;
+	blockOpen = false;
+}
+
+void Generator::Goto(char const* label)
+{
+	char line[MAX_LINE];
+	sprintf(line, "b %s", label);
+	Ins(line);
+	Ins("nop");
+	numBlocks++;
+	blockOpen = false;
+}
+
+void Generator::Generate(int numProcs, int procBlocks, ostream* o)
+{
+	state = initSeed;
+	nextLabel = 1;
+	out = o;
+	blockOpen = false;
+	numIns = numLabels = numBlocks = 0;
+	maxLen = 0;
+
+	for (int p = 0; p < numProcs; p++)
+	{
+		// a realistic program has many small procedures and a few large ones
+		long size = procBlocks;
+		if (shape == MixedShape)
+		{
+			double r = Random(1000) / 1000.0;
+			size = 1 + (long)(3.0 * procBlocks * r * r);
+		}
+
+		char name[32];
+		sprintf(name, "proc%d", p);
+		Label(name);
+		Ins("save %sp,-112,%sp");
+		Body(0, size);
+		Ins("ret");
+		Ins("restore");
+		numBlocks++;
+		blockOpen = false;
+	}
+}
+
+long Generator::Body(int depth, long budget)
+{
+	long start = numBlocks;
+	while (numBlocks - start < budget)
+	{
+		long left = budget - (numBlocks - start);
+
+		// choose a statement, with straight code once the nesting is deep enough
+		int r = Random(100);
+		int c;
+		for (c = 0; c < NUM_CONSTRUCTS - 1 && r >= weights[shape][c]; c++)
+			r -= weights[shape][c];
+		if (depth >= maxDepth && c != CallsCon)
+			c = StraightCon;
+
+		switch (c) {
+		case StraightCon:
+			Straight();
+			break;
+		case CallsCon:
+			Calls(left);
+			break;
+		case WhileCon:
+			While(depth, left);
+			break;
+		case RepeatCon:
+			Repeat(depth, left);
+			break;
+		case IfCon:
+			If(depth, left);
+			break;
+		case LadderCon:
+			Ladder(depth, left);
+			break;
+		case SwitchCon:
+			Switch(depth, left);
+			break;
+		default:
+			Irreducible(depth, left);
+			break;
+		}
+	}
+	return numBlocks - start;
+}
+
+void Generator::Straight()
+{
+	char line[MAX_LINE];
+	int n = 1 + Random(3);
+	for (int i = 0; i < n; i++)
+	{
+		sprintf(line, "add %%o%ld,%ld,%%o%ld", Random(6), Random(10), Random(6));
+		Ins(line);
+	}
+	Label(NewLabel());
+}
+
+int Generator::Width(long budget)
+// each arm takes at least two blocks
+{
+	long w = budget / 2;
+	if (w > width)
+		w = width;
+	if (w < 2)
+		w = 2;
+	return 2 + Random(w - 1);
+}
+
+void Generator::Calls(long budget)
+// each call ends a block that falls through to the next
+{
+	char line[MAX_LINE];
+	int n = 1 + Random(budget < width ? budget : width);
+	for (int i = 0; i < n; i++)
+	{
+		sprintf(line, "add %%o%ld,%ld,%%o0", Random(6), Random(10));
+		Ins(line);
+		sprintf(line, "call f%ld,0", Random(10));
+		Ins(line);
+		Ins("nop");
+		numBlocks++;
+		blockOpen = false;
+	}
+}
+
+void Generator::While(int depth, long budget)
+// loops take most of the budget so that they nest deeply
+{
+	char head[32], follow[32];
+	strcpy(head, NewLabel());
+	strcpy(follow, NewLabel());
+
+	Label(head);
+	Branch(follow);
+	Body(depth + 1, budget / 2 + Random(budget / 2 + 1));
+	Goto(head);
+	Label(follow);
+}
+
+void Generator::Repeat(int depth, long budget)
+{
+	char head[32];
+	strcpy(head, NewLabel());
+
+	Label(head);
+	Body(depth + 1, budget / 2 + Random(budget / 2 + 1));
+	Branch(head);
+}
+
+void Generator::If(int depth, long budget)
+{
+	char elseLabel[32], end[32];
+	strcpy(elseLabel, NewLabel());
+	strcpy(end, NewLabel());
+
+	Branch(elseLabel);
+	Body(depth + 1, Random(budget) / 2);
+	if (Random(10) < 6)
+	{
+		Goto(end);
+		Label(elseLabel);
+		Body(depth + 1, Random(budget) / 2);
+		Label(end);
+	}
+	else
+		Label(elseLabel);
+}
+
+void Generator::Ladder(int depth, long budget)
+{
+	char next[32], end[32];
+	int n = Width(budget);
+	long arm = budget / (n + 1) - 2;
+	if (arm < 0)
+		arm = 0;
+	strcpy(end, NewLabel());
+
+	for (int i = 0; i < n; i++)
+	{
+		strcpy(next, NewLabel());
+		Branch(next);
+		Body(depth + 1, Random(arm + 1));
+		Goto(end);
+		Label(next);
+	}
+	Body(depth + 1, Random(arm + 1));
+	Label(end);
+}
+
+void Generator::Switch(int depth, long budget)
+{
+	int n = Width(budget);
+	long arm = budget / n - 1;
+	if (arm < 0)
+		arm = 0;
+	long first = nextLabel;
+	char end[32];
+
+	// the jmp names the labels of its cases, which are numbered in order
+	char line[MAX_LINE];
+	int len = 5;
+	nextLabel += n;
+	strcpy(end, NewLabel());
+	if (out)
+		*out << "\tjmp";
+	for (int i = 0; i < n; i++)
+	{
+		sprintf(line, " .LL%ld", first + i);
+		len += strlen(line);
+		if (out)
+			*out << line;
+	}
+	if (out)
+		*out << '\n';
+	if (len > maxLen)
+		maxLen = len;
+	numIns++;
+	Ins("nop");
+	numBlocks++;
+	blockOpen = false;
+
+	for (int i = 0; i < n; i++)
+	{
+		sprintf(line, ".LL%ld", first + i);
+		Label(line);
+		Body(depth + 1, Random(arm + 1));
+		Goto(end);
+	}
+	Label(end);
+}
+
+void Generator::Irreducible(int depth, long budget)
+// the loop is entered at its head and, by the branch, in the middle
+{
+	char head[32], middle[32];
+	strcpy(head, NewLabel());
+	strcpy(middle, NewLabel());
+
+	Branch(middle);
+	Label(head);
+	Body(depth + 1, Random(budget) / 4);
+	Label(middle);
+	Body(depth + 1, Random(budget) / 4);
+	Branch(head);
+}
+
+static void Usage(char* progname)
+{
+	cerr << "Usage: " << progname << " [-n blocks] [-b blocks] [-k shape] [-d depth] [-w width] [-s seed]" <<
+		" [-o file]" << endl;
+	cerr << "\t-n the number of blocks in the program (default " << DEFAULT_BLOCKS << ")" << endl;
+	cerr << "\t-b the number of blocks in each procedure (default " << DEFAULT_PROC_BLOCKS << ")" << endl;
+	cerr << "\t-k the shape of the procedures: loops, ladder, switch, irreducible," << endl;
+	cerr << "\t    calls or mixed (the default)" << endl;
+	cerr << "\t-d the deepest nesting of the statements (default " << DEFAULT_DEPTH << ")" << endl;
+	cerr << "\t-w the most arms of a ladder, cases of a switch and calls of a chain" << endl;
+	cerr << "\t    (default that of the shape)" << endl;
+	cerr << "\t-s the seed of the random numbers (default " << DEFAULT_SEED << ")" << endl;
+	cerr << "\t-o the file the program is written to (default the standard output)" << endl;
+	exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+	char* progname = argv[0];
+	long blocks = DEFAULT_BLOCKS;
+	int procBlocks = DEFAULT_PROC_BLOCKS;
+	genShape shape = MixedShape;
+	int depth = DEFAULT_DEPTH;
+	int width = 0;
+	long seed = DEFAULT_SEED;
+	char* fname = NULL;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (argv[i][0] != '-' || argv[i][1] == '\0' || argv[i][2] != '\0' || i + 1 == argc)
+			Usage(progname);
+		char* value = argv[++i];
+		switch (argv[i - 1][1]) {
+		case 'n':
+			blocks = atol(value);
+			break;
+		case 'b':
+			procBlocks = atoi(value);
+			break;
+		case 'k':
+			for (shape = LoopsShape; shape < NUM_SHAPES; shape = (genShape)(shape + 1))
+				if (strcmp(value, ShapeName[shape]) == 0)
+					break;
+			break;
+		case 'd':
+			depth = atoi(value);
+			break;
+		case 'w':
+			width = atoi(value);
+			if (width < 1)
+				Usage(progname);
+			break;
+		case 's':
+			seed = atol(value);
+			break;
+		case 'o':
+			fname = value;
+			break;
+		default:
+			Usage(progname);
+		}
+	}
+	if (blocks < 1 || procBlocks < 1 || shape == NUM_SHAPES || depth < 0 || seed < 1 ||
+		 seed > 2147483646)
+		Usage(progname);
+
+	Generator gen(shape, seed, depth, width);
+	int numProcs = (int)((blocks + procBlocks - 1) / procBlocks);
+
+	// count the instructions and labels
+	gen.Generate(numProcs, procBlocks, NULL);
+
+	ostream* out = &cout;
+	ofstream file;
+	if (fname)
+	{
+		file.open(fname);
+
+		//make sure file was successfully opened
+		if (!file)
+		{
+			cerr << "Error: could not open output file." << endl;
+			exit(1);
+		}
+		out = &file;
+	}
+
+	*out << gen.NumIns() << '\n' << gen.NumLabels() << '\n' << gen.MaxLen() << '\n';
+	gen.Generate(numProcs, procBlocks, out);
+	out->flush();
+
+	if (!*out)
+	{
+		cerr << "Error: could not write to " << (fname ? fname : "the standard output") << "." << endl;
+		exit(1);
+	}
+	cerr << gen.NumBlocks() << " blocks in " << numProcs << " " << ShapeName[shape] <<
+		" procedures" << endl;
+	return 0;
+}
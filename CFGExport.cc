@@ -0,0 +1,294 @@
+/*
+ * Copyright (C) 1997, Doug Simon
+ *
+ * See the file "LICENSE.TERMS" for information on usage and
+ * redistribution of this file, and for a DISCLAIMER OF ALL
+ * WARRANTIES.
+ *
+ */
+
+//File: CFGExport.cc
+//Author: Doug Simon
+//Purpose: provides the implementation of the writers that export the graphs
+
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <iostream.h>
+#include "CFGExport.h"
+#include "Graphs.h"
+#include "StringFunctions.h"
+
+extern char* StructString[];
+extern char* LoopString[];
+extern char* CondString[];
+
+//*********************************************************************
+// The fields of a node
+//*********************************************************************
+// return the order of a node (-1 if there is none)
+static int OrderOf(CFGNode const* node) { return node ? node->Order() : -1; }
+
+static int Ident(CFGNode const* node) { return node->Ident(); }
+static int RevOrder(CFGNode const* node) { return node->RevOrder(); }
+static int Type(CFGNode const* node) { return node->GetType(); }
+static int NumIns(CFGNode const* node) { return node->Instructions().Size(); }
+static int ImmPDom(CFGNode const* node) { return OrderOf(node->GetImmPDom()); }
+static int Struct(CFGNode const* node) { return node->GetStructType(); }
+static int LoopHead(CFGNode const* node) { return OrderOf(node->GetLoopHead()); }
+static int CaseHead(CFGNode const* node) { return OrderOf(node->GetCaseHead()); }
+static int Latch(CFGNode const* node) { return OrderOf(node->GetLatchNode()); }
+static int LoopFollow(CFGNode const* node) { return OrderOf(node->GetLoopFollow()); }
+static int CondFollow(CFGNode const* node) { return OrderOf(node->GetCondFollow()); }
+
+static int LoopKind(CFGNode const* node)
+{
+	structType s = node->GetStructType();
+	return s == Loop || s == LoopCond ? node->GetLoopType() : -1;
+}
+
+static int CondKind(CFGNode const* node)
+{
+	structType s = node->GetStructType();
+	return s == Cond || s == LoopCond ? node->GetCondType() : -1;
+}
+
+static char const* TypeName(CFGNode const* node) { return Type2String(node->GetType()); }
+static char const* StructName(CFGNode const* node) { return StructString[node->GetStructType()]; }
+
+static char const* LoopName(CFGNode const* node)
+{
+	int l = LoopKind(node);
+	return l == -1 ? NULL : LoopString[l];
+}
+
+static char const* CondName(CFGNode const* node)
+{
+	int c = CondKind(node);
+	return c == -1 ? NULL : CondString[c];
+}
+
+// the fields in the order they are written. A type is given in the JSON Lines by its
+// name (NULL for none).
+static struct {
+	char const* name;
+	int (*value)(CFGNode const*);
+	char const* (*typeName)(CFGNode const*);
+} const fields[] = {
+	{ "ident", Ident, NULL },
+	{ "revOrder", RevOrder, NULL },
+	{ "type", Type, TypeName },
+	{ "ins", NumIns, NULL },
+	{ "immPDom", ImmPDom, NULL },
+	{ "struct", Struct, StructName },
+	{ "loopType", LoopKind, LoopName },
+	{ "condType", CondKind, CondName },
+	{ "loopHead", LoopHead, NULL },
+	{ "caseHead", CaseHead, NULL },
+	{ "latch", Latch, NULL },
+	{ "loopFollow", LoopFollow, NULL },
+	{ "condFollow", CondFollow, NULL }
+};
+
+#define NUM_FIELDS (int)(sizeof(fields) / sizeof(fields[0]))
+
+//*********************************************************************
+// The parts shared by both forms
+//*********************************************************************
+CFGWriter::CFGWriter(char const* fname, char const* ext) : name(concatstr(fname, ext))
+{
+	fd = open(name, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+
+	//make sure file was successfully opened
+	if (fd < 0)
+	{
+		cerr << "Error: could not open output file." << endl;
+		exit(1);
+	}
+}
+
+CFGWriter::~CFGWriter()
+{
+	delete[] name;
+}
+
+void CFGWriter::Flush()
+{
+	if (!out.Flush(fd))
+	{
+		cerr << "Error: could not write to " << name << "." << endl;
+		exit(1);
+	}
+}
+
+void CFGWriter::WriteProc(char const* name, int cls, NodePtrArr const &order,
+	CFGNode const* entry, CFGNode const* exit)
+{
+	Proc(name, cls, order, entry, exit);
+
+	// send the output to the file once enough has been collected
+	if (out.Size() >= EMIT_FLUSH_SIZE)
+		Flush();
+}
+
+void CFGWriter::Finish()
+{
+	Flush();
+	close(fd);
+}
+
+//*********************************************************************
+// The binary form
+//*********************************************************************
+CSRWriter::CSRWriter(char const* fname) : CFGWriter(fname, ".csr")
+{
+	out.Add("CSR", 3);
+	out.Add((char)CSR_FORMAT_VERSION);
+}
+
+void CSRWriter::AddWord(int n)
+{
+	// the bytes are given one by one so that the form doesn't depend on the host
+	out.Add((char)(n & 0xff));
+	out.Add((char)((n >> 8) & 0xff));
+	out.Add((char)((n >> 16) & 0xff));
+	out.Add((char)((n >> 24) & 0xff));
+}
+
+void CSRWriter::Proc(char const* name, int cls, NodePtrArr const &order,
+	CFGNode const* entry, CFGNode const* exit)
+{
+	int n = order.Size();
+	int m = 0;
+	for (int i = 0; i < n; i++)
+		m += order[i]->GetOutEdges().Size();
+
+	int len = strlen(name);
+	int padded = (len + 3) & ~3;
+
+	// the size of the rest of the record is known before it is added
+	AddWord(4 + padded + 5 * 4 + (n + 1) * 4 + m * 4 + NUM_FIELDS * n * 4);
+
+	AddWord(len);
+	out.Add(name, len);
+	for (int i = len; i < padded; i++)
+		out.Add('\0');
+
+	AddWord(cls);
+	AddWord(n);
+	AddWord(m);
+	AddWord(OrderOf(entry));
+	AddWord(OrderOf(exit));
+
+	int start = 0;
+	for (int i = 0; i < n; i++)
+	{
+		AddWord(start);
+		start += order[i]->GetOutEdges().Size();
+	}
+	AddWord(start);
+
+	for (int i = 0; i < n; i++)
+	{
+		NodePtrArr const &outEdges = order[i]->GetOutEdges();
+		for (int j = 0; j < outEdges.Size(); j++)
+			AddWord(outEdges[j]->Order());
+	}
+
+	for (int f = 0; f < NUM_FIELDS; f++)
+		for (int i = 0; i < n; i++)
+			AddWord(fields[f].value(order[i]));
+}
+
+//*********************************************************************
+// JSON Lines
+//*********************************************************************
+// add an integer that may be negative
+static void AddNum(HLLEmitter &out, int n)
+{
+	if (n < 0)
+	{
+		out.Add('-');
+		n = -n;
+	}
+	out.AddInt(n);
+}
+
+void JSONLWriter::AddColumn(char const* field, NodePtrArr const &order,
+	int (*value)(CFGNode const*))
+{
+	out.Add(",\"");
+	out.Add(field);
+	out.Add("\":[");
+	for (int i = 0; i < order.Size(); i++)
+	{
+		if (i)
+			out.Add(',');
+		AddNum(out, value(order[i]));
+	}
+	out.Add(']');
+}
+
+void JSONLWriter::AddNames(char const* field, NodePtrArr const &order,
+	char const* (*value)(CFGNode const*))
+{
+	out.Add(",\"");
+	out.Add(field);
+	out.Add("\":[");
+	for (int i = 0; i < order.Size(); i++)
+	{
+		if (i)
+			out.Add(',');
+		char const* str = value(order[i]);
+		if (str)
+			out.AddJSONString(str);
+		else
+			out.Add("null", 4);
+	}
+	out.Add(']');
+}
+
+void JSONLWriter::Proc(char const* name, int cls, NodePtrArr const &order,
+	CFGNode const* entry, CFGNode const* exit)
+{
+	int n = order.Size();
+	int m = 0;
+	for (int i = 0; i < n; i++)
+		m += order[i]->GetOutEdges().Size();
+
+	out.Add("{\"proc\":");
+	out.AddJSONString(name);
+	out.Add(",\"class\":");
+	out.AddJSONString(GraphClass2String((graphClass)cls));
+	out.Add(",\"nodes\":");
+	out.AddInt(n);
+	out.Add(",\"edges\":");
+	out.AddInt(m);
+	out.Add(",\"entry\":");
+	AddNum(out, OrderOf(entry));
+	out.Add(",\"exit\":");
+	AddNum(out, OrderOf(exit));
+
+	out.Add(",\"succ\":[");
+	for (int i = 0; i < n; i++)
+	{
+		NodePtrArr const &outEdges = order[i]->GetOutEdges();
+		out.Add(i ? ",[" : "[");
+		for (int j = 0; j < outEdges.Size(); j++)
+		{
+			if (j)
+				out.Add(',');
+			out.AddInt(outEdges[j]->Order());
+		}
+		out.Add(']');
+	}
+	out.Add(']');
+
+	for (int f = 0; f < NUM_FIELDS; f++)
+		if (fields[f].typeName)
+			AddNames(fields[f].name, order, fields[f].typeName);
+		else
+			AddColumn(fields[f].name, order, fields[f].value);
+	out.Add("}\n", 2);
+}
@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 1997, Doug Simon
+ *
+ * See the file "LICENSE.TERMS" for information on usage and
+ * redistribution of this file, and for a DISCLAIMER OF ALL
+ * WARRANTIES.
+ *
+ */
+
+//File: CFGExport.h
+//Author: Doug Simon
+//Purpose: provides the writers that export the graph of each procedure along with the
+//	results of structuring it, for tools that analyse them. Each procedure is written
+//	as soon as it has been structured. The nodes of a procedure are numbered by their
+//	order and a node that isn't there (such as the follow of a node that has none) is
+//	given as -1. Each node has the following fields:
+//
+//	ident		the identifier of the node (as used in the graphviz output)
+//	revOrder	the order of the node in the reverse graph
+//	type		the type of basic block (bbType in TypeDefs.h)
+//	ins			the number of instructions
+//	immPDom		the immediate post dominator
+//	struct		the structured type (structType in Node.h)
+//	loopType	the type of loop of a loop header (loopType in Node.h, -1 if not one)
+//	condType	the type of conditional of a conditional header (condType in Node.h, -1
+//				if not one)
+//	loopHead	the header of the most nested loop that holds the node
+//	caseHead	the header of the most nested case that holds the node
+//	latch		the latching node of a loop header
+//	loopFollow	the follow of a loop header
+//	condFollow	the follow of a conditional header
+//
+//	CSRWriter	the binary form written to <file>.csr. The file starts with the bytes
+//				"CSR" and the format version, followed by a record for each
+//				procedure. Each number in a record is a 32 bit little endian integer.
+//				A record is
+//					the number of bytes in the rest of the record
+//					the length of the name and its characters, padded with zero bytes
+//					to a multiple of four
+//					class (graphClass in Graphs.h), #nodes n, #edges m, entry, exit
+//					edgeStart[n + 1], edges[m]: the out edges of node i are
+//					edges[edgeStart[i]] to edges[edgeStart[i + 1] - 1]
+//					each field in the order above as a column of n numbers
+//	JSONLWriter	JSON Lines written to <file>.jsonl. Each procedure is an object on
+//				its own line:
+//					{"proc":name,"class":name,"nodes":n,"edges":m,"entry":e,
+//					"exit":x,"succ":[[node,...],...],"ident":[...],...}
+//				with an array of n values for each field. The types are given by
+//				name and are null where the number would be -1.
+
+#ifndef _CFGEXPORT_
+#define _CFGEXPORT_
+
+#include "Node.h"
+#include "HLLEmitter.h"
+
+#define CSR_FORMAT_VERSION 1		// the version of the binary form
+
+class CFGWriter {
+public:
+	// Post: the file <fname><ext> has been opened for the output
+	CFGWriter(char const* fname, char const* ext);
+
+	virtual ~CFGWriter();
+
+	// write the graph of a procedure of the given class (graphClass in Graphs.h). Its
+	// nodes are given by order.
+	void WriteProc(char const* name, int cls, NodePtrArr const &order, CFGNode const* entry,
+		CFGNode const* exit);
+
+	// write out anything still held and close the file
+	void Finish();
+
+protected:
+	// add the record of a procedure
+	virtual void Proc(char const* name, int cls, NodePtrArr const &order, CFGNode const* entry,
+		CFGNode const* exit) = 0;
+
+	HLLEmitter out;					// the output waiting to be written
+	char* name;							// the name of the output file
+	int fd;								// the output file
+
+private:
+	// write out the output collected so far
+	void Flush();
+};
+
+class CSRWriter : public CFGWriter {
+public:
+	CSRWriter(char const* fname);
+
+protected:
+	void Proc(char const* name, int cls, NodePtrArr const &order, CFGNode const* entry,
+		CFGNode const* exit);
+
+private:
+	// add a 32 bit little endian integer
+	void AddWord(int n);
+};
+
+class JSONLWriter : public CFGWriter {
+public:
+	JSONLWriter(char const* fname) : CFGWriter(fname, ".jsonl") {}
+
+protected:
+	void Proc(char const* name, int cls, NodePtrArr const &order, CFGNode const* entry,
+		CFGNode const* exit);
+
+private:
+	// add a field given by a number for each node
+	void AddColumn(char const* field, NodePtrArr const &order, int (*value)(CFGNode const*));
+
+	// add a field given by a name for each node
+	void AddNames(char const* field, NodePtrArr const &order, char const* (*value)(CFGNode const*));
+};
+
+#endif
@@ -43,11 +43,14 @@ void Graphs::FindImmedPDom (ProcHeader* curProc)
 {
 	CFGNode *curNode, *succNode;	// the current Node and its successor
 	NodePtrArr &revOrder = curProc->revOrdering;
+	bool const* done = curProc->preStructured;	// nodes whose post dominator is already known
 
 	// traverse the nodes in order (i.e from the bottom up)
 	for (int i = revOrder.Size() - 1; i >= 0; i--)
 	{
 		curNode = revOrder[i];
+		if (done && done[curNode->Order()])
+			continue;
 		NodePtrArr const &oEdges = curNode->GetOutEdges();
 		for (int j = 0; j < oEdges.Size(); j++) 
 		{
@@ -62,6 +65,8 @@ void Graphs::FindImmedPDom (ProcHeader* curProc)
 	for (int i = 0; i < order.Size(); i++)
 	{
 		curNode = order[i];
+		if (done && done[i])
+			continue;
 		NodePtrArr const &oEdges = curNode->GetOutEdges();
 		if (oEdges.Size() > 1)
 			for (int j = 0; j < oEdges.Size(); j++) 
@@ -75,6 +80,8 @@ void Graphs::FindImmedPDom (ProcHeader* curProc)
 	for (int i = 0; i < order.Size(); i++)
 	{
 		curNode = order[i];
+		if (done && done[i])
+			continue;
 		NodePtrArr const &oEdges = curNode->GetOutEdges();
 		if (oEdges.Size() > 1)
 			for (int j = 0; j < oEdges.Size(); j++) 
@@ -89,8 +96,15 @@ void Graphs::FindImmedPDom (ProcHeader* curProc)
 	}
 
 #ifdef TESTPOSTDOM
+	// the exact immediate post dominators are the immediate dominators of the reverse
+	// graph entered at the exit node. They are shown beside the ones found above.
+	CFGView cfg = {&order, curProc->cfg->Order()};
+	ReverseGraph<CFGView> revCfg = {&cfg, curProc->exitNode->Order()};
+	int* exact = new int[order.Size()];
+	ImmDominators(revCfg, exact);
+
 	cerr << "\nImmediate post dominator info for procedure " << curProc->name << endl;
-	cerr << "Node\t| ImmPDom" << endl;
+	cerr << "Node\t| ImmPDom\t| Exact" << endl;
 	for (int i = 0; i < order.Size(); i++)
 	{
 		curNode = order[i];
@@ -102,7 +116,12 @@ void Graphs::FindImmedPDom (ProcHeader* curProc)
 			cerr << "\t|  " << curNode->GetImmPDom()->Order();
 		else
 			cerr << "\t|  -";
+		if (exact[i] != -1 && exact[i] != i)
+			cerr << "\t\t|  " << exact[i];
+		else
+			cerr << "\t\t|  -";
 		cerr << endl;
 	}
+	delete[] exact;
 #endif
 }
@@ -0,0 +1,928 @@
+/*
+ * Copyright (C) 1997, Doug Simon
+ *
+ * See the file "LICENSE.TERMS" for information on usage and
+ * redistribution of this file, and for a DISCLAIMER OF ALL
+ * WARRANTIES.
+ *
+ */
+
+// File: GraphAlgs.h
+// Author: Doug Simon
+// Purpose: provides templates for the graph algorithms used by the structuring
+//	phases: depth first orderings, immediate dominators, the loop forest, the strongly
+//	connected components, the interval partition and the program structure tree of a
+//	graph. Each is written against GraphTraits (see GraphTraits.h) and only needs the
+//	out edges of a graph. The arrays taken and returned are indexed by node number.
+//	NOTE: The function definitions have been included in this file so that each
+//		algorithm is instantiated for the graph type it is used with.
+
+#ifndef _GRAPHALGS_
+#define _GRAPHALGS_
+
+#include <string.h>
+#include <assert.h>
+#include "GraphTraits.h"
+
+//*********************************************************************
+// Depth first orderings
+//*********************************************************************
+template <class G>
+int DfsOrder(G const& g, int* pre, int* atPre, int* last, int* post)
+// Post: pre[n] is the preorder number of n (-1 if n isn't reached from the entry) and
+//		  atPre[p] is the node with preorder number p. last[n] is the highest preorder
+//		  number of the descendants of n in the DFS tree, so v is a descendant of w if
+//		  pre[w] <= pre[v] <= last[w]. If post isn't NULL, post[n] is the postorder
+//		  number of n. The number of nodes reached is returned.
+{
+	typedef GraphTraits<G> T;
+	int n = T::NumNodes(g);
+	int* stack = new int[n];
+	int* next = new int[n];
+	int i, time = 0, postTime = 0, top = 0;
+
+	for (i = 0; i < n; i++)
+	{
+		pre[i] = -1;
+		next[i] = 0;
+	}
+
+	int entry = T::Entry(g);
+	stack[top++] = entry;
+	pre[entry] = time;
+	atPre[time++] = entry;
+	while (top != 0)
+	{
+		int cur = stack[top - 1];
+
+		if (next[cur] < T::NumSuccs(g, cur))
+		{
+			int child = T::Succ(g, cur, next[cur]++);
+			if (pre[child] == -1)
+			{
+				pre[child] = time;
+				atPre[time++] = child;
+				stack[top++] = child;
+			}
+		}
+		else
+		{
+			last[cur] = time - 1;
+			if (post)
+				post[cur] = postTime++;
+			top--;
+		}
+	}
+
+	delete[] stack;
+	delete[] next;
+	return time;
+}
+
+//*********************************************************************
+// Build the in edges of g from its out edges. The sources of the in edges
+// of node n are preds[predStart[n]] to preds[predStart[n + 1] - 1].
+//*********************************************************************
+template <class G>
+void BuildPreds(G const& g, int* &predStart, int* &preds)
+{
+	typedef GraphTraits<G> T;
+	int n = T::NumNodes(g);
+	int i, j;
+
+	predStart = new int[n + 1];
+	for (i = 0; i <= n; i++)
+		predStart[i] = 0;
+	for (i = 0; i < n; i++)
+		for (j = 0; j < T::NumSuccs(g, i); j++)
+			predStart[T::Succ(g, i, j) + 1]++;
+	for (i = 0; i < n; i++)
+		predStart[i + 1] += predStart[i];
+
+	// fill in the sources, using the start of each node as its insertion point
+	// and then moving the starts back into place
+	preds = new int[predStart[n]];
+	for (i = 0; i < n; i++)
+		for (j = 0; j < T::NumSuccs(g, i); j++)
+			preds[predStart[T::Succ(g, i, j)]++] = i;
+	for (i = n; i > 0; i--)
+		predStart[i] = predStart[i - 1];
+	predStart[0] = 0;
+}
+
+//*********************************************************************
+// Immediate dominators
+//*********************************************************************
+template <class G>
+void ImmDominators(G const& g, int* idom)
+// Post: idom[n] is the immediate dominator of n, idom[entry] is the entry and
+//		  idom[n] is -1 if n isn't reached from the entry.
+// Uses the iterative algorithm of Cooper, Harvey and Kennedy over the reverse postorder.
+{
+	typedef GraphTraits<G> T;
+	int n = T::NumNodes(g);
+	int* pre = new int[n];
+	int* atPre = new int[n];
+	int* last = new int[n];
+	int* post = new int[n];
+	int* predStart;
+	int* preds;
+	int i, j;
+
+	int numReached = DfsOrder(g, pre, atPre, last, post);
+	BuildPreds(g, predStart, preds);
+
+	// atPost[p] is the node with postorder number p
+	int* atPost = last;
+	for (i = 0; i < n; i++)
+	{
+		idom[i] = -1;
+		if (pre[i] != -1)
+			atPost[post[i]] = i;
+	}
+
+	int entry = T::Entry(g);
+	idom[entry] = entry;
+	bool changed = true;
+	while (changed)
+	{
+		changed = false;
+		for (int p = numReached - 2; p >= 0; p--)
+		{
+			int cur = atPost[p];
+			int newIdom = -1;
+			for (j = predStart[cur]; j < predStart[cur + 1]; j++)
+			{
+				int a = preds[j];
+				if (idom[a] == -1)
+					continue;
+				if (newIdom == -1)
+				{
+					newIdom = a;
+					continue;
+				}
+
+				// find the nearest common dominator of a and newIdom
+				int b = newIdom;
+				while (a != b)
+				{
+					while (post[a] < post[b])
+						a = idom[a];
+					while (post[b] < post[a])
+						b = idom[b];
+				}
+				newIdom = a;
+			}
+			if (idom[cur] != newIdom)
+			{
+				idom[cur] = newIdom;
+				changed = true;
+			}
+		}
+	}
+
+	delete[] pre;
+	delete[] atPre;
+	delete[] last;
+	delete[] post;
+	delete[] predStart;
+	delete[] preds;
+}
+
+//*********************************************************************
+// The loop forest
+//*********************************************************************
+
+// Return the loop header that node n has been merged into
+inline int FindLoopHeader(int* header, int n)
+{
+	while (header[n] != n)
+	{
+		header[n] = header[header[n]];
+		n = header[n];
+	}
+	return n;
+}
+
+template <class G>
+int LoopForest(G const& g, int* loopParent, bool &reducible)
+// Post: loopParent[n] is the header of the innermost loop that contains n (not counting
+//		  a loop headed by n) or -1 if there is none. reducible is set to whether or not
+//		  the graph is reducible and the number of loops is returned. The loops found in an
+//		  irreducible graph are only those that have a single entry.
+// Uses Tarjan's test: the nodes are visited in reverse preorder and the body of each
+// loop is collapsed onto its header with union-find. The graph is irreducible if some
+// node of a loop body is entered from outside the DFS subtree of the header.
+{
+	typedef GraphTraits<G> T;
+	int n = T::NumNodes(g);
+	int* pre = new int[n];
+	int* last = new int[n];
+	int* atPre = new int[n];
+	int* header = new int[n];
+	int* inBody = new int[n];
+	int* stack = new int[n];
+	int* predStart;
+	int* preds;
+	int i, j;
+
+	int numReached = DfsOrder(g, pre, atPre, last, (int*)NULL);
+	BuildPreds(g, predStart, preds);
+
+	for (i = 0; i < n; i++)
+	{
+		header[i] = i;
+		inBody[i] = loopParent[i] = -1;
+	}
+
+	int numLoops = 0;
+	reducible = true;
+	for (int p = numReached - 1; p >= 0; p--)
+	{
+		int w = atPre[p];
+		bool isHeader = false;
+		int top = 0;
+
+		// the sources of the back edges into w start the body of its loop
+		for (j = predStart[w]; j < predStart[w + 1]; j++)
+		{
+			int v = preds[j];
+			if (pre[w] <= pre[v] && pre[v] <= last[w])
+			{
+				isHeader = true;
+				v = FindLoopHeader(header, v);
+				if (v != w && inBody[v] != w)
+				{
+					inBody[v] = w;
+					stack[top++] = v;
+				}
+			}
+		}
+
+		if (!isHeader)
+			continue;
+		numLoops++;
+
+		// work back from the back edges, adding the predecessors of each body node
+		// that aren't yet in the loop. Each node is merged into a loop once and that
+		// is its innermost loop.
+		while (top != 0)
+		{
+			int x = stack[--top];
+			header[x] = w;
+			loopParent[x] = w;
+
+			for (j = predStart[x]; j < predStart[x + 1]; j++)
+			{
+				int y = preds[j];
+
+				// skip unreached nodes and the back edges into x, which belong to a
+				// loop headed by x
+				if (pre[y] == -1 || (pre[x] <= pre[y] && pre[y] <= last[x]))
+					continue;
+
+				y = FindLoopHeader(header, y);
+				if (!(pre[w] <= pre[y] && pre[y] <= last[w]))
+					reducible = false;
+				else if (y != w && inBody[y] != w)
+				{
+					inBody[y] = w;
+					stack[top++] = y;
+				}
+			}
+		}
+	}
+
+	delete[] pre;
+	delete[] last;
+	delete[] atPre;
+	delete[] header;
+	delete[] inBody;
+	delete[] stack;
+	delete[] predStart;
+	delete[] preds;
+	return numLoops;
+}
+
+//*********************************************************************
+// Strongly connected components
+//*********************************************************************
+template <class G>
+int StrongComponents(G const& g, int* comp)
+// Post: comp[n] is the strongly connected component of n (-1 if n isn't reached from
+//		  the entry). The components are numbered in the order they are completed so a
+//		  component is numbered before any component that reaches it. The number of
+//		  components is returned.
+// Uses Tarjan's algorithm with an explicit stack.
+{
+	typedef GraphTraits<G> T;
+	int n = T::NumNodes(g);
+	int* low = new int[n];
+	int* num = new int[n];
+	int* next = new int[n];
+	int* dfsStack = new int[n];
+	int* sccStack = new int[n];
+	int i, time = 0, top = 0, sccTop = 0, numComps = 0;
+
+	for (i = 0; i < n; i++)
+	{
+		num[i] = comp[i] = -1;
+		next[i] = 0;
+	}
+
+	int entry = T::Entry(g);
+	num[entry] = low[entry] = time++;
+	dfsStack[top++] = sccStack[sccTop++] = entry;
+	while (top != 0)
+	{
+		int cur = dfsStack[top - 1];
+
+		if (next[cur] < T::NumSuccs(g, cur))
+		{
+			int child = T::Succ(g, cur, next[cur]++);
+			if (num[child] == -1)
+			{
+				num[child] = low[child] = time++;
+				dfsStack[top++] = sccStack[sccTop++] = child;
+			}
+			else if (comp[child] == -1 && num[child] < low[cur])
+				// the child is still on the component stack
+				low[cur] = num[child];
+		}
+		else
+		{
+			top--;
+			if (top != 0 && low[cur] < low[dfsStack[top - 1]])
+				low[dfsStack[top - 1]] = low[cur];
+
+			// cur is the root of a component made of the nodes above it on the stack
+			if (low[cur] == num[cur])
+			{
+				int m;
+				do {
+					m = sccStack[--sccTop];
+					comp[m] = numComps;
+				} while (m != cur);
+				numComps++;
+			}
+		}
+	}
+
+	delete[] low;
+	delete[] num;
+	delete[] next;
+	delete[] dfsStack;
+	delete[] sccStack;
+	return numComps;
+}
+
+//*********************************************************************
+// The interval partition
+//*********************************************************************
+
+// Add v to the end of a growable array of integers
+inline void AddInt(int* &arr, int &size, int &avail, int v)
+{
+	if (size == avail)
+	{
+		int* newArr = new int[avail * 2];
+		memcpy(newArr, arr, sizeof(int) * size);
+		delete[] arr;
+		arr = newArr;
+		avail *= 2;
+	}
+	arr[size++] = v;
+}
+
+// Add node to the interval curInt and count the in edges from the interval to each
+// of the children of node
+template <class G>
+void AddToInterval(G const& g, int curInt, int node, int* intOf, int* &members, int &numMembers,
+	int &memAvail, int* numInside, int* insideOf)
+{
+	typedef GraphTraits<G> T;
+
+	intOf[node] = curInt;
+	AddInt(members, numMembers, memAvail, node);
+
+	for (int i = 0; i < T::NumSuccs(g, node); i++)
+	{
+		int succ = T::Succ(g, node, i);
+		if (insideOf[succ] != curInt)
+		{
+			insideOf[succ] = curInt;
+			numInside[succ] = 0;
+		}
+		numInside[succ]++;
+	}
+}
+
+template <class G>
+int PartitionIntervals(G const& g, int* intOf, int* &intStart, int* &members)
+// Post: the intervals of g have been numbered from 0 in the order they were built and
+//		  the members of interval i are members[intStart[i]] to members[intStart[i + 1] - 1]
+//		  in the order they were added. intOf[n] is the interval that n was last added to.
+//		  The number of intervals is returned.
+{
+	typedef GraphTraits<G> T;
+	int n = T::NumNodes(g);
+	int i, j;
+
+	// The sequence of interval header nodes is a queue in which each node is placed
+	// at most once. A node added to an interval while on the queue is marked as no
+	// longer being on it rather than being removed.
+	int* headerSeq = new int[n];
+	int first = 0, lastH = 0;
+	bool* beenInH = new bool[n];		// has the node been in the header sequence?
+	bool* inH = new bool[n];			// is the node still in the header sequence?
+
+	// The in edges of each node are counted. The number of in edges from nodes of
+	// the interval being built is also kept so that a node is known to have all of
+	// its parents inside the interval when the two counts are equal.
+	int* numInEdges = new int[n];
+	int* numInside = new int[n];
+	int* insideOf = new int[n];		// the interval numInside is being kept for
+
+	for (i = 0; i < n; i++)
+	{
+		beenInH[i] = inH[i] = false;
+		numInEdges[i] = numInside[i] = 0;
+		intOf[i] = insideOf[i] = -1;
+	}
+	for (i = 0; i < n; i++)
+		for (j = 0; j < T::NumSuccs(g, i); j++)
+			numInEdges[T::Succ(g, i, j)]++;
+
+	// the members of the intervals are grouped by interval in the order they were added
+	int numInts = 0;
+	int numMembers = 0, memAvail = n;
+	intStart = new int[n + 1];
+	members = new int[memAvail];
+
+	// Initialise the header sequence to contain the head of the graph
+	int entry = T::Entry(g);
+	headerSeq[lastH++] = entry;
+	beenInH[entry] = inH[entry] = true;
+
+	// Keep processing the header sequence until it is empty
+	while (first != lastH)
+	{
+		// Remove the head of the headers sequence and set it to be the head of a new interval
+		int header = headerSeq[first++];
+		if (!inH[header])
+			continue;
+		inH[header] = false;
+
+		int curInt = numInts++;
+		intStart[curInt] = numMembers;
+		AddToInterval(g, curInt, header, intOf, members, numMembers, memAvail, numInside, insideOf);
+
+		// Process each succesive node in the interval until no more nodes can be added to the interval.
+		for (i = intStart[curInt]; i < numMembers; i++)
+		{
+			int curNode = members[i];
+
+			// Process each child of the current node
+			for (j = 0; j < T::NumSuccs(g, curNode); j++)
+			{
+				int succ = T::Succ(g, curNode, j);
+
+				// Only further consider the current child if it isn't already in the interval
+				if (intOf[succ] != curInt)
+				{
+					// If the current child has all its parents inside the interval, then
+					// add it to the interval. Remove it from the header sequence if it is on it.
+					if (insideOf[succ] == curInt && numInside[succ] == numInEdges[succ])
+					{
+						AddToInterval(g, curInt, succ, intOf, members, numMembers, memAvail, numInside, insideOf);
+						inH[succ] = false;
+					}
+
+					// Otherwise, add it to the header sequence if it hasn't already been in it.
+					else if (!beenInH[succ])
+					{
+						headerSeq[lastH++] = succ;
+						beenInH[succ] = inH[succ] = true;
+					}
+				}
+			}
+		}
+	}
+	intStart[numInts] = numMembers;
+
+	delete[] headerSeq;
+	delete[] beenInH;
+	delete[] inH;
+	delete[] numInEdges;
+	delete[] numInside;
+	delete[] insideOf;
+	return numInts;
+}
+
+template <class G>
+void CondenseIntervals(G const& g, int numInts, int const* intOf, int const* intStart,
+	int const* members, int* &outStart, int* &outEdges)
+// Pre: the intervals of g have been built by PartitionIntervals
+// Post: the out edges of the graph whose nodes are the intervals of g have been built.
+//		  Each edge of g that leads outside an interval becomes an edge of that interval.
+{
+	typedef GraphTraits<G> T;
+	int i, j, k;
+
+	// count the edges that lead from each interval to another one
+	int numEdges = 0;
+	for (i = 0; i < numInts; i++)
+		for (j = intStart[i]; j < intStart[i + 1]; j++)
+			for (k = 0; k < T::NumSuccs(g, members[j]); k++)
+				if (intOf[T::Succ(g, members[j], k)] != i)
+					numEdges++;
+
+	outStart = new int[numInts + 1];
+	outEdges = new int[numEdges];
+	numEdges = 0;
+	for (i = 0; i < numInts; i++)
+	{
+		outStart[i] = numEdges;
+		for (j = intStart[i]; j < intStart[i + 1]; j++)
+			for (k = 0; k < T::NumSuccs(g, members[j]); k++)
+			{
+				int dest = intOf[T::Succ(g, members[j], k)];
+				if (dest != i)
+					outEdges[numEdges++] = dest;
+			}
+	}
+	outStart[numInts] = numEdges;
+}
+
+//*********************************************************************
+// Cycle equivalence and the program structure tree
+//
+// The edges of g are numbered by their source and then by their position, so
+// the ith out edge of n is edge edgeStart[n] + i. An edge from the exit back to
+// the entry is added to make g strongly connected and is numbered last.
+//*********************************************************************
+// remove bracket b from the bracket list with the given head, tail and size
+inline void UnlinkBracket(int b, int* bNext, int* bPrev, int &head, int &tail, int &size)
+{
+	if (bPrev[b] == -1)
+		head = bNext[b];
+	else
+		bNext[bPrev[b]] = bNext[b];
+	if (bNext[b] == -1)
+		tail = bPrev[b];
+	else
+		bPrev[bNext[b]] = bPrev[b];
+	size--;
+}
+
+// push bracket b onto the top of the bracket list with the given head, tail and size
+inline void PushBracket(int b, int* bNext, int* bPrev, int &head, int &tail, int &size)
+{
+	bPrev[b] = -1;
+	bNext[b] = head;
+	if (size == 0)
+		tail = b;
+	else
+		bPrev[head] = b;
+	head = b;
+	size++;
+}
+
+template <class G>
+int CycleEquivalence(G const& g, int exit, int* &edgeStart, int* &edgeClass)
+// Pre: every node of g is reached from the entry and reaches exit
+// Post: edgeClass[e] is the cycle equivalence class of edge e. Two edges are in the
+//		  same class if every cycle through one of them goes through the other. The
+//		  number of classes is returned.
+// Uses the bracket lists of Johnson, Pearson and Pingali over a depth first search of
+// the undirected graph, so it takes time linear in the number of edges.
+{
+	typedef GraphTraits<G> T;
+	int n = T::NumNodes(g);
+	int entry = T::Entry(g);
+	int i, j, k, e;
+
+	edgeStart = new int[n + 1];
+	edgeStart[0] = 0;
+	for (i = 0; i < n; i++)
+		edgeStart[i + 1] = edgeStart[i] + T::NumSuccs(g, i);
+	int m = edgeStart[n] + 1;
+	int* src = new int[m];
+	int* dst = new int[m];
+	for (i = 0; i < n; i++)
+		for (j = 0; j < T::NumSuccs(g, i); j++)
+		{
+			src[edgeStart[i] + j] = i;
+			dst[edgeStart[i] + j] = T::Succ(g, i, j);
+		}
+	src[m - 1] = exit;
+	dst[m - 1] = entry;
+
+	// store both ends of each edge in the undirected graph. A self loop is in a class
+	// of its own and is left out.
+	int numClasses = 0;
+	int* adjStart = new int[n + 1];
+	int* next = new int[n];
+	edgeClass = new int[m];
+	for (i = 0; i <= n; i++)
+		adjStart[i] = 0;
+	for (e = 0; e < m; e++)
+	{
+		edgeClass[e] = -1;
+		if (src[e] == dst[e])
+			edgeClass[e] = numClasses++;
+		else
+		{
+			adjStart[src[e] + 1]++;
+			adjStart[dst[e] + 1]++;
+		}
+	}
+	for (i = 0; i < n; i++)
+	{
+		adjStart[i + 1] += adjStart[i];
+		next[i] = adjStart[i];
+	}
+	int* adj = new int[adjStart[n]];
+	for (e = 0; e < m; e++)
+		if (src[e] != dst[e])
+		{
+			adj[next[src[e]]++] = e;
+			adj[next[dst[e]]++] = e;
+		}
+
+	// number the nodes in depth first order. Every edge that isn't a tree edge joins a
+	// node to one of its ancestors and is a back edge.
+	int* dfsNum = new int[n];
+	int* atDfs = new int[n];
+	int* parentEdge = new int[n];
+	int* stack = new int[n];
+	bool* isBack = new bool[m];
+	int time = 0, top = 0;
+	for (i = 0; i < n; i++)
+	{
+		dfsNum[i] = parentEdge[i] = -1;
+		next[i] = adjStart[i];
+	}
+	for (e = 0; e < m; e++)
+		isBack[e] = false;
+
+	dfsNum[entry] = time;
+	atDfs[time++] = entry;
+	stack[top++] = entry;
+	while (top != 0)
+	{
+		int cur = stack[top - 1];
+
+		if (next[cur] < adjStart[cur + 1])
+		{
+			e = adj[next[cur]++];
+			if (e == parentEdge[cur])
+				continue;
+			int other = (src[e] == cur ? dst[e] : src[e]);
+			if (dfsNum[other] == -1)
+			{
+				dfsNum[other] = time;
+				atDfs[time++] = other;
+				parentEdge[other] = e;
+				stack[top++] = other;
+			}
+			else if (dfsNum[other] < dfsNum[cur])
+				isBack[e] = true;
+		}
+		else
+			top--;
+	}
+
+	// The brackets of a tree edge are the back edges from the subtree below it to the
+	// nodes above it. The bracket list of each node is kept as a doubly linked list with
+	// its top at the head. Brackets numbered from m are the capping back edges.
+	int numBrackets = m + n;
+	int* bNext = new int[numBrackets];
+	int* bPrev = new int[numBrackets];
+	int* recentSize = new int[numBrackets];
+	int* recentClass = new int[numBrackets];
+	int* capNext = new int[numBrackets];
+	int* capHead = new int[n];
+	int* listHead = new int[n];
+	int* listTail = new int[n];
+	int* listSize = new int[n];
+	int* hi = new int[n];
+	int numCaps = 0;
+	for (i = 0; i < numBrackets; i++)
+		recentSize[i] = -1;
+	for (i = 0; i < n; i++)
+		capHead[i] = -1;
+
+	// visit the nodes bottom up so that the lists of the children of a node are built first
+	for (int t = time - 1; t >= 0; t--)
+	{
+		int cur = atDfs[t];
+		int hi0 = n, hi1 = n, hi2 = n;
+
+		// hi0 is the highest node reached by a back edge from cur, hi1 the highest node
+		// reached from below cur and hi2 the highest reached from below cur other than
+		// through the child giving hi1. The lists of the children are joined together.
+		listHead[cur] = listTail[cur] = -1;
+		listSize[cur] = 0;
+		for (k = adjStart[cur]; k < adjStart[cur + 1]; k++)
+		{
+			e = adj[k];
+			int other = (src[e] == cur ? dst[e] : src[e]);
+			if (isBack[e] && dfsNum[other] < dfsNum[cur])
+			{
+				if (dfsNum[other] < hi0)
+					hi0 = dfsNum[other];
+			}
+			else if (!isBack[e] && parentEdge[other] == e)
+			{
+				if (hi[other] < hi1)
+				{
+					hi2 = hi1;
+					hi1 = hi[other];
+				}
+				else if (hi[other] < hi2)
+					hi2 = hi[other];
+
+				if (listSize[other] != 0)
+				{
+					if (listSize[cur] == 0)
+						listHead[cur] = listHead[other];
+					else
+					{
+						bNext[listTail[cur]] = listHead[other];
+						bPrev[listHead[other]] = listTail[cur];
+					}
+					listTail[cur] = listTail[other];
+					listSize[cur] += listSize[other];
+				}
+			}
+		}
+		hi[cur] = (hi0 < hi1 ? hi0 : hi1);
+
+		// remove the capping back edges and the back edges that end at cur. A back edge
+		// that hasn't been found equivalent to a tree edge is in a class of its own.
+		for (k = capHead[cur]; k != -1; k = capNext[k])
+			UnlinkBracket(k, bNext, bPrev, listHead[cur], listTail[cur], listSize[cur]);
+		for (k = adjStart[cur]; k < adjStart[cur + 1]; k++)
+		{
+			e = adj[k];
+			int other = (src[e] == cur ? dst[e] : src[e]);
+			if (isBack[e] && dfsNum[other] > dfsNum[cur])
+			{
+				UnlinkBracket(e, bNext, bPrev, listHead[cur], listTail[cur], listSize[cur]);
+				if (edgeClass[e] == -1)
+					edgeClass[e] = numClasses++;
+			}
+		}
+
+		// push the back edges from cur and a capping back edge that stands in for the
+		// brackets of the other children that reach above cur
+		for (k = adjStart[cur]; k < adjStart[cur + 1]; k++)
+		{
+			e = adj[k];
+			int other = (src[e] == cur ? dst[e] : src[e]);
+			if (isBack[e] && dfsNum[other] < dfsNum[cur])
+				PushBracket(e, bNext, bPrev, listHead[cur], listTail[cur], listSize[cur]);
+		}
+		if (hi2 < hi0 && hi2 < dfsNum[cur])
+		{
+			int cap = m + numCaps++;
+			capNext[cap] = capHead[atDfs[hi2]];
+			capHead[atDfs[hi2]] = cap;
+			PushBracket(cap, bNext, bPrev, listHead[cur], listTail[cur], listSize[cur]);
+		}
+
+		// the class of the tree edge into cur is decided by the top bracket and the
+		// number of brackets. A tree edge without any brackets is in a class of its own.
+		if (cur != entry)
+		{
+			e = parentEdge[cur];
+			if (listSize[cur] == 0)
+				edgeClass[e] = numClasses++;
+			else
+			{
+				int b = listHead[cur];
+				if (recentSize[b] != listSize[cur])
+				{
+					recentSize[b] = listSize[cur];
+					recentClass[b] = numClasses++;
+				}
+				edgeClass[e] = recentClass[b];
+				if (recentSize[b] == 1 && b < m)
+					edgeClass[b] = edgeClass[e];
+			}
+		}
+	}
+
+	delete[] src;
+	delete[] dst;
+	delete[] adjStart;
+	delete[] adj;
+	delete[] next;
+	delete[] dfsNum;
+	delete[] atDfs;
+	delete[] parentEdge;
+	delete[] stack;
+	delete[] isBack;
+	delete[] bNext;
+	delete[] bPrev;
+	delete[] recentSize;
+	delete[] recentClass;
+	delete[] capNext;
+	delete[] capHead;
+	delete[] listHead;
+	delete[] listTail;
+	delete[] listSize;
+	delete[] hi;
+	return numClasses;
+}
+
+template <class G>
+int StructureTree(G const& g, int exit, int const* edgeStart, int const* edgeClass, int numClasses,
+	int* &regionParent, int* regionOf)
+// Pre: edgeStart and edgeClass have been set by CycleEquivalence
+// Post: regionOf[n] is the smallest canonical single entry single exit region that
+//		  contains n and regionParent[r] is the smallest region enclosing region r. Region
+//		  0 is the whole graph and every other region is numbered after its parent. The
+//		  number of regions is returned, or -1 if the regions don't nest.
+// A canonical region is bounded by two edges of a class that follow each other on every
+// path through them. A depth first search meets the edges of a class in that order so
+// each edge closes the region opened by the one before it and opens the next.
+{
+	typedef GraphTraits<G> T;
+	int n = T::NumNodes(g);
+	int entry = T::Entry(g);
+	int m = edgeStart[n] + 1;
+	int* count = new int[numClasses];
+	int* seen = new int[numClasses];
+	int* open = new int[numClasses];
+	int* stack = new int[n];
+	int* next = new int[n];
+	int i, top = 0, numRegions = 1;
+
+	for (i = 0; i < numClasses; i++)
+	{
+		count[i] = seen[i] = 0;
+		open[i] = -1;
+	}
+	for (i = 0; i < m; i++)
+		count[edgeClass[i]]++;
+	for (i = 0; i < n; i++)
+	{
+		regionOf[i] = -1;
+		next[i] = 0;
+	}
+
+	regionParent = new int[m + 1];
+	regionParent[0] = -1;
+	regionOf[entry] = 0;
+	stack[top++] = entry;
+	while (top != 0 && numRegions != -1)
+	{
+		int cur = stack[top - 1];
+		int numSuccs = T::NumSuccs(g, cur);
+
+		// the exit also has the added edge back to the entry
+		if (next[cur] < numSuccs + (cur == exit ? 1 : 0))
+		{
+			int idx = next[cur]++;
+			int e = (idx < numSuccs ? edgeStart[cur] + idx : m - 1);
+			int dest = (idx < numSuccs ? T::Succ(g, cur, idx) : entry);
+			int c = edgeClass[e];
+			int region = regionOf[cur];
+
+			if (open[c] != -1)
+			{
+				// the edge must leave the region opened by the last edge of its class
+				if (open[c] != region)
+				{
+					numRegions = -1;
+					break;
+				}
+				region = regionParent[region];
+				open[c] = -1;
+			}
+			if (++seen[c] < count[c])
+			{
+				regionParent[numRegions] = region;
+				open[c] = region = numRegions++;
+			}
+			if (regionOf[dest] == -1)
+			{
+				regionOf[dest] = region;
+				stack[top++] = dest;
+			}
+		}
+		else
+			top--;
+	}
+
+	delete[] count;
+	delete[] seen;
+	delete[] open;
+	delete[] stack;
+	delete[] next;
+	return numRegions;
+}
+
+#endif
@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 1997, Doug Simon
+ *
+ * See the file "LICENSE.TERMS" for information on usage and
+ * redistribution of this file, and for a DISCLAIMER OF ALL
+ * WARRANTIES.
+ *
+ */
+
+// File: GraphTraits.h
+// Author: Doug Simon
+// Purpose: provides the GraphTraits template through which the graph algorithms of
+//	GraphAlgs.h see a graph. The nodes of a graph are numbered from 0 and a
+//	specialization of GraphTraits for a graph type G must provide:
+//
+//		static int NumNodes(G const& g);				// the number of nodes
+//		static int Entry(G const& g);					// the entry node
+//		static int NumSuccs(G const& g, int n);		// the number of out edges of n
+//		static int Succ(G const& g, int n, int i);	// the destination of the ith out edge of n
+//
+//	A graph that also keeps its in edges may provide the following, which are needed
+//	to view it through a ReverseGraph:
+//
+//		static int NumPreds(G const& g, int n);		// the number of in edges of n
+//		static int Pred(G const& g, int n, int i);	// the source of the ith in edge of n
+//
+//	Every function is resolved at compile time so an algorithm is specialized for
+//	each type of graph it is used with.
+
+#ifndef _GRAPHTRAITS_
+#define _GRAPHTRAITS_
+
+#include "Node.h"
+
+template <class G>
+struct GraphTraits;
+
+// define a type to view the cfg of a procedure as a graph whose nodes are numbered
+// by their order
+struct CFGView {
+	NodePtrArr const* order;	// the ordering of the nodes of the procedure
+	int entry;						// the order of the entry node
+};
+
+template <>
+struct GraphTraits<CFGView> {
+	static int NumNodes(CFGView const& g) { return g.order->Size(); }
+	static int Entry(CFGView const& g) { return g.entry; }
+	static int NumSuccs(CFGView const& g, int n) { return (*g.order)[n]->GetOutEdges().Size(); }
+	static int Succ(CFGView const& g, int n, int i) { return (*g.order)[n]->GetOutEdges()[i]->Order(); }
+	static int NumPreds(CFGView const& g, int n) { return (*g.order)[n]->GetInEdges().Size(); }
+	static int Pred(CFGView const& g, int n, int i) { return (*g.order)[n]->GetInEdges()[i]->Order(); }
+};
+
+// define a type to view a graph with its edges reversed, entered at the given node
+template <class G>
+struct ReverseGraph {
+	G const* graph;
+	int entry;
+};
+
+template <class G>
+struct GraphTraits< ReverseGraph<G> > {
+	static int NumNodes(ReverseGraph<G> const& g) { return GraphTraits<G>::NumNodes(*g.graph); }
+	static int Entry(ReverseGraph<G> const& g) { return g.entry; }
+	static int NumSuccs(ReverseGraph<G> const& g, int n) { return GraphTraits<G>::NumPreds(*g.graph, n); }
+	static int Succ(ReverseGraph<G> const& g, int n, int i) { return GraphTraits<G>::Pred(*g.graph, n, i); }
+	static int NumPreds(ReverseGraph<G> const& g, int n) { return GraphTraits<G>::NumSuccs(*g.graph, n); }
+	static int Pred(ReverseGraph<G> const& g, int n, int i) { return GraphTraits<G>::Succ(*g.graph, n, i); }
+};
+
+#endif
@@ -19,9 +19,48 @@
 #endif
 
 Graphs::Graphs() :
-	nodeList(0), tail(0), procs(0)
+	nodeList(0), tail(0), nextId(1), procs(0)
 {}
 
+Graphs::~Graphs()
+{
+	while (procs)
+	{
+		ProcHeader* curProc = procs;
+		procs = curProc->next;
+
+		for (int i = 0; i < curProc->derivedGraphs.Size(); i++)
+		{
+			DerivedGraph* derGraph = curProc->derivedGraphs[i];
+			delete[] derGraph->outStart;
+			delete[] derGraph->outEdges;
+			delete[] derGraph->intOf;
+			delete[] derGraph->intStart;
+			delete[] derGraph->members;
+			delete derGraph;
+		}
+		if (curProc->pst)
+		{
+			delete[] curProc->pst->parent;
+			delete[] curProc->pst->regionOf;
+			delete curProc->pst;
+		}
+		delete curProc->diff;
+		delete[] curProc->preStructured;
+		delete[] curProc->stamps.loopIn;	// the other stamp columns share its array
+		delete[] curProc->name;
+		delete curProc;
+	}
+
+	while (nodeList)
+	{
+		CFGNode* curNode = nodeList;
+		nodeList = curNode->Next();
+		delete curNode;
+	}
+	tail = 0;
+}
+
 void Graphs::append(CFGNode const* node)
 {
 	if (!nodeList)
@@ -77,6 +116,7 @@ void Graphs::BuildNodes(Source const &src)
 		}
 		count++;
 	}
+	nextId = bId;
 #ifdef TESTGRAPHS
 	for (newNode = nodeList; newNode != 0; newNode = newNode->Next())
 	{
@@ -223,6 +263,25 @@ void Graphs::DefineCfgs()
 			newProc->size = 1;
 			newProc->cfg = curNode;
 			newProc->exitNode = 0;
+			newProc->splitNodes = newProc->splitIns = newProc->splitEntries = 0;
+			newProc->splitTime = 0.0;
+			newProc->irreducible = false;
+			newProc->numGotos = newProc->numLoops = newProc->num2ways = newProc->numNways = 0;
+			newProc->numContBrks = newProc->maxIndent = 0;
+			for (int p = 0; p < NUM_PHASES; p++)
+			{
+				newProc->phaseTime[p] = 0.0;
+				newProc->phaseMem[p] = 0;
+			}
+			for (int e = 0; e < NUM_PERF_EVENTS; e++)
+				newProc->perf[e] = 0;
+			newProc->cls = Irreducible;
+			newProc->stamps.loopIn = NULL;
+			newProc->derSeqTime = 0.0;
+			newProc->derSeqMem = 0;
+			newProc->diff = NULL;
+			newProc->pst = NULL;
+			newProc->preStructured = NULL;
 			newProc->next = procs;
 			procs = newProc;
 		}
@@ -242,11 +301,15 @@ void Graphs::DefineCfgs()
 #endif
 }
 
+#include "GraphsSplit.cc"
 #include "GraphsDfs.cc"
-#ifdef INTERVALS
 #include "GraphsDerSeq.cc"
-#endif
+#include "GraphsClassify.cc"
 #include "Dominators.cc"
 #include "Analysis.cc"
+#include "GraphsPST.cc"
+#include "GraphsDiff.cc"
 #include "GraphsCodeGen.cc"
+#include "GraphsView.cc"
 #include "GraphsPrint.cc"
+#include "GraphsMetrics.cc"
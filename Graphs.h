@@ -18,25 +18,82 @@
 #include "Source.h"
 #include "Instruction.h"
 #include "TypeDefs.h"
+#include "Options.h"
+#include "GraphAlgs.h"
+#include "Stats.h"
 
-#ifdef INTERVALS
-// define a type to store the information about a derived graph
+class HLLEmitter;
+
+// define a type to store the information about a derived graph. The nodes of a
+// derived graph are numbered from 0 and its edges are stored as one array with
+// the out edges of each node stored together.
 struct DerivedGraph {
-	CFGNode* cfg;				// head of derived graph
 	int numOfNodes;			// number of nodes in this graph
-	NodePtrArr intervals;	// intervals of derived graph
+	int head;					// the head node of this graph
+	int* outStart;				// index of the first out edge of each node (numOfNodes + 1 entries)
+	int* outEdges;				// destination of each out edge
+	int numOfInts;				// number of intervals of this graph
+	int* intOf;					// the interval that each node was last added to
+	int* intStart;				// index of the first member of each interval (numOfInts + 1 entries)
+	int* members;				// the nodes of each interval in the order they were added
+};
+
+template <>
+struct GraphTraits<DerivedGraph> {
+	static int NumNodes(DerivedGraph const& g) { return g.numOfNodes; }
+	static int Entry(DerivedGraph const& g) { return g.head; }
+	static int NumSuccs(DerivedGraph const& g, int n) { return g.outStart[n + 1] - g.outStart[n]; }
+	static int Succ(DerivedGraph const& g, int n, int i) { return g.outEdges[g.outStart[n] + i]; }
 };
 
 // define a type to store a sequence of derived graphs
 typedef DynArr<DerivedGraph*> DGPtrArr;
-#endif
+
+// define a type to store the results of structuring a graph with both algorithms.
+// The arrays are indexed by structurer.
+struct StructDiff {
+	double time[2];			// time taken to prepare for and structure the graph
+	int mem[2];					// memory added while preparing for and structuring the graph
+	int numLoops[2];			// number of loops found
+	int numGotos[2];			// number of conditionals structured as a jump into/outof a loop or case
+	int loopDiffs;				// number of nodes whose loop decisions differ
+	int condDiffs;				// number of nodes whose conditional decisions differ
+	int gotoDiffs;				// number of conditionals whose jump decision differs
+};
+
+// define a type to store the program structure tree of a procedure. Each region is a
+// canonical single entry single exit region of the cfg. Region 0 is the whole cfg and
+// every other region is numbered after the region that encloses it.
+struct PST {
+	int numRegions;			// number of regions (-1 if the tree couldn't be built)
+	int* parent;				// the smallest region enclosing each region (-1 for region 0)
+	int* regionOf;				// the smallest region containing each node indexed by order
+};
+
+// an enumerated type for the class of a cfg determined by the shape of its loops
+// (NUM_GRAPH_CLASSES in Stats.h must match the number of classes)
+enum graphClass {
+	StraightLine,		// a single chain of nodes ending at the exit
+	Acyclic,				// no loops
+	SingleLoop,			// reducible with exactly one loop
+	Reducible,			// reducible with more than one loop
+	Irreducible			// has a loop with more than one entry
+};
+
+// return the name of a class of cfg
+char const* GraphClass2String(graphClass c);
 
 class Graphs {
 public:
+	// the microbenchmarks time the private analysis kernels one by one (see AstBench.cc)
+	friend class KernelBench;
 
 	// default constructor
 	Graphs();						
 
+	// destructor frees the nodes and the headers of each cfg
+	~Graphs();
+
 	// build the set of nodes from the source instructions
 	void BuildNodes(Source const &src);		
 
@@ -46,30 +103,52 @@ public:
 	// build the headers for each cfg within the program
 	void DefineCfgs();					
 
+	// Split the nodes of any irreducible cfg until it becomes reducible or the
+	// duplication budget given on the command line is used up
+	void SplitNodes();
+
+	// Display the results of splitting nodes for each procedure
+	void DisplaySplits();
+
 	// Give each node its DFS generated orderings.
 	void SetTimeStamps();				
 
-#ifdef INTERVALS
 	// Build the sequence of derived graphs for each procedure
 	void BuildDerivedSequences();
 
 	// Display the sequence of derived graphs for each procedure
 	void DisplayDerivedSequences();
-#endif
 
-	// apply the structuring algorithm to each CFG
-	void Structure();				
+	// classify each CFG by the shape of its loops
+	void Classify();
+
+	// apply the structuring algorithm to each CFG. With the --diff option each CFG
+	// is also structured with the other algorithm first. Each CFG is exported to fname
+	// in the forms given by the options as soon as it has been structured.
+	void Structure(char* fname);
+
+	// Display the differences between the two structuring algorithms for each procedure
+	void DisplayDiffs();
 
 	// generate the structured HLL code and only perform the goto removal post
 	// processor if required by the command line arguments
 	void CodeGen(char* fname);
 
-	// generate graphviz output and store it in fname
+	// generate graphviz output and store it in fname in the layout and for the
+	// procedures given by the options
 	void GenerateGraphvizFile(char* fname);	
 
+	// write the metrics of each procedure to fname in the form given by the options
+	void WriteProcStats(char* fname);
+
+	// Display the n procedures that took the most time over the phases measured for
+	// each procedure
+	void DisplaySlowest(int n);
+
 private:
 	CFGNode* nodeList;			// head of the linked list of nodes
 	CFGNode* tail;					// tail of the linked list of nodes (next insertion point)
+	int nextId;						// the next unused node identifier
 
 	struct ProcHeader {
 		CFGNode* cfg;					// The node at the head of the graph
@@ -82,9 +161,32 @@ private:
 		NodePtrArr revOrdering;	// an array of pointers to the nodes
 											// within this procedure such that the nodes lower in
 											// reverse graph are earlier in the array
-#ifdef INTERVALS
+		StampCols stamps;			// the time stamp tuples of the nodes indexed by their order
 		DGPtrArr derivedGraphs;	// the derived graphs for this procedure
-#endif
+		double derSeqTime;			// time taken to build the derived graphs
+		int derSeqMem;					// memory taken by the derived graphs
+		StructDiff* diff;				// the results of structuring with both algorithms
+		int splitNodes;				// number of nodes duplicated by node splitting
+		int splitIns;					// number of instructions in these nodes
+		int splitEntries;				// number of region entries removed by node splitting
+		double splitTime;				// time taken to split the nodes
+		bool irreducible;				// is the graph still irreducible after node splitting?
+		int numGotos;					// number of goto's generated for this procedure
+		int numLoops;					// number of loops generated for this procedure
+		int num2ways;					// number of if-then-{else}'s generated
+		int numNways;					// number of switch's generated
+		int numContBrks;				// number of continue's or break's generated
+		int maxIndent;					// maximum indentation level reached
+		double phaseTime[NUM_PHASES];	// wall clock time taken by each phase for this
+											// procedure (see GraphsMetrics.cc for the phases
+											// measured)
+		long phaseMem[NUM_PHASES];	// memory allocated by each phase for this procedure
+		long long perf[NUM_PERF_EVENTS];	// the hardware events counted over the phases
+											// measured for this procedure
+		graphClass cls;				// the class of the graph (see Classify)
+		PST* pst;						// the program structure tree (built when first needed)
+		bool* preStructured;			// the nodes indexed by order that were structured by
+											// StructRegions (NULL if none were)
 		ProcHeader* next;
 	}* procs;
 
@@ -93,31 +195,95 @@ private:
 	void DfsTag(CFGNode* curNode);		// do a dfs on the list of nodes
 	void DfsVisit(CFGNode* curNode, int &time, NodePtrArr &revOrder);
 
+	// Reduce the graph of curProc by T1/T2 transformations and if it is irreducible, split
+	// the cheapest region with more than one predecessor that fits in the budget.
+	// Returns true if a region was split.
+	bool SplitRegion(ProcHeader* curProc, int &budget);
+
+	// Return the class of the graph for curProc
+	graphClass ClassifyProc(ProcHeader* curProc);
+
+	// Build the program structure tree of curProc
+	void BuildPST(ProcHeader* curProc);
+
+	// Find the post dominators of and structure the conditionals within the regions of
+	// curProc that don't depend on the rest of the graph, using the number of threads
+	// given on the command line
+	void StructRegions(ProcHeader* curProc);
+
+	// find the post dominators of and structure the conditionals of the nodes of a
+	// region, given in decreasing reverse order and in order
+	void StructRegion(CFGNode** byRevOrder, CFGNode** byOrder, int numNodes);
+
+	// the work shared by the threads of StructRegions and the function they run
+	struct RegionWork;
+	static void* RegionWorker(void* arg);
+
+	// should the graph of curProc be put in the graphviz output?
+	bool DotWanted(ProcHeader const* curProc) const;
+
+	// the graph of a procedure condensed into its structured regions (see GraphsView.cc)
+	struct DotView;
+
+	// return the view of curProc in which each region nested maxDepth + 1 deep is shown
+	// as one summary node
+	DotView* CondenseProc(ProcHeader const* curProc, int maxDepth);
+
+	// add the graphviz nodes and edges of curProc to dot, each line after indent,
+	// writing out to fd whenever enough has been collected. Only the nodes and summary
+	// nodes of view are added if it is given. Returns false if a write failed.
+	bool WriteDotProc(HLLEmitter &dot, int fd, ProcHeader const* curProc, DotView const* view,
+		char const* indent);
+
+	// the work shared by the threads that write a graphviz file for each procedure
+	// and the function they run
+	struct DotWork;
+	static void* DotWorker(void* arg);
+
 	void FindImmedPDom (ProcHeader* curProc);
 	CFGNode* CommonPDom (CFGNode* curImmPDom, CFGNode* predImmPDom);
 
-	void StructLoops(ProcHeader* curProc);
+	// Set the reverse loop stamps that the parenthesis theory structurer uses and copy
+	// the stamps of the nodes into columns
+	void SetRevTimeStamps(ProcHeader* curProc);
+
+	// the time, memory and hardware events so far when a phase started for a procedure
+	struct ProcMark {
+		double wall;
+		long mem;
+		long long perf[NUM_PERF_EVENTS];
+	};
+
+	// start measuring a phase for a procedure, recording the time, memory and events so
+	// far in mark, and add what the phase took since then to curProc
+	static void StartProcPhase(ProcMark &mark);
+	static void EndProcPhase(ProcHeader* curProc, toolPhase p, ProcMark const &mark);
+
+	// return the time taken by curProc over the phases measured for each procedure
+	static double ProcTotalTime(ProcHeader const* curProc);
+
+	// apply the given structuring algorithm to the CFG of curProc
+	void StructureProc(ProcHeader* curProc, structurer alg);
+
+	// structure the CFG of curProc with both algorithms, recording the differences
+	void DiffStructure(ProcHeader* curProc);
+
+	void StructLoops(ProcHeader* curProc, structurer alg);
+	void StructParenLoops(ProcHeader* curProc);
+	void StructIntervalLoops(ProcHeader* curProc);
 	void StructConds(ProcHeader* curProc);
 	void CheckConds(ProcHeader* curProc);
 
-#ifdef INTERVALS
-	// Build the intervals for a given derived graph
-	// Pre: space must have been allocated for the derived graph and its cfg header must have been set
-	// Post: the derived graphs now contains its list of intervals
-	void BuildIntervals(DerivedGraph* derGraph);
-	
 	// Build the derived sequence of graphs within a CFG
 	void BuildDerivedSequence(ProcHeader* proc);
 
-	// Pre: the number of nodes in the current graph must be greater than the number of intervals 
-	//		  determined for the current graph
-	// Build the next order graph from the current derived graph
-	void BuildNextOrderGraph(DerivedGraph* curGraph, DerivedGraph* nextGraph);
+	// Set cfgNodes for the order of each basic block within the given interval of the
+	// derived graph at the given level
+	void FindNodesInInt(ProcHeader* proc, int level, int interval, bool* cfgNodes);
 
-	void DisplayIntervals(NodePtrArr const &intSeq);
+	void DisplayIntervals(DerivedGraph* derGraph, int level);
 	
 	void DisplayDerivedSequence(ProcHeader* proc);
-#endif
 };
 	
 #endif
@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 1997, Doug Simon
+ *
+ * See the file "LICENSE.TERMS" for information on usage and
+ * redistribution of this file, and for a DISCLAIMER OF ALL
+ * WARRANTIES.
+ *
+ */
+
+//File: GraphsClassify.cpp
+//Author: Doug Simon
+//Purpose: gives the implementation of the classification of each cfg by the shape
+//	of its loops. The class of a graph decides which of the structuring phases
+//	have any work to do for it. The loops are found with the LoopForest template of
+//	GraphAlgs.h.
+
+char const* GraphClass2String(graphClass c)
+{
+	switch (c) {
+	case StraightLine:
+		return "straight-line";
+	case Acyclic:
+		return "acyclic";
+	case SingleLoop:
+		return "single-loop";
+	case Reducible:
+		return "reducible";
+	case Irreducible:
+	default:
+		return "irreducible";
+	}
+}
+
+//*********************************************************************
+// Classify the cfg of each procedure
+//*********************************************************************
+void Graphs::Classify()
+{
+#ifdef GETSTATS
+	double t[3] = {0,0,0};
+	dtime(t);
+#endif
+
+	for (ProcHeader* curProc = procs; curProc; curProc = curProc->next)
+	{
+#ifdef GETSTATS
+		ProcMark mark;
+		StartProcPhase(mark);
+#endif
+		curProc->cls = ClassifyProc(curProc);
+#ifdef GETSTATS
+		EndProcPhase(curProc, ClassifyPhase, mark);
+		stats.numClass[curProc->cls]++;
+#endif
+	}
+
+#ifdef GETSTATS
+	dtime(t);
+	stats.classifyTime = t[1];
+#endif
+}
+
+graphClass Graphs::ClassifyProc(ProcHeader* curProc)
+// Pre: the nodes have been given their ordering
+{
+	CFGView cfg = {&curProc->Ordering, curProc->cfg->Order()};
+	int* loopParent = new int[curProc->Ordering.Size()];
+	bool reducible;
+	bool isLine = true;
+
+	int numLoops = LoopForest(cfg, loopParent, reducible);
+	delete[] loopParent;
+
+	for (int i = 0; i < curProc->Ordering.Size() && isLine; i++)
+		if (curProc->Ordering[i]->GetOutEdges().Size() > 1)
+			isLine = false;
+
+	if (!reducible)
+		return Irreducible;
+	else if (numLoops > 1)
+		return Reducible;
+	else if (numLoops == 1)
+		return SingleLoop;
+	else if (isLine && curProc->exitNode->Order() == 0)
+		// the exit is the last node in postorder so the graph is a single chain of
+		// nodes ending at the exit
+		return StraightLine;
+	else
+		return Acyclic;
+}
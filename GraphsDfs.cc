@@ -15,9 +15,14 @@
 
 void Graphs::SetTimeStamps()
 {
-	//do the time stamping used for loop structuring 
+	//do the time stamping used for loop structuring. The reverse loop stamps are
+	//only needed by the parenthesis theory structurer and are set by SetRevTimeStamps
 	for (ProcHeader* curProc = procs; curProc; curProc = curProc->next)
 	{
+#ifdef GETSTATS
+		ProcMark mark;
+		StartProcPhase(mark);
+#endif
 		int time = 1;
 		NodePtrArr &order = curProc->Ordering;
 
@@ -26,22 +31,48 @@ void Graphs::SetTimeStamps()
 		// set the parenthesis for the nodes as well as setting
 		// the post-order ordering between the nodes
 		curProc->cfg->SetLoopStamps(time,order);
-
-#ifndef INTERVALS
-		// set the reverse parenthesis for the nodes
-		time = 1;
-		curProc->cfg->SetRevLoopStamps(time);
+#ifdef GETSTATS
+		EndProcPhase(curProc, SetTimeStampsPhase, mark);
 #endif
 	}
 
 	// do the ordering of nodes within the reverse graph 
 	for (ProcHeader* curProc = procs; curProc; curProc = curProc->next)
 	{
+#ifdef GETSTATS
+		ProcMark mark;
+		StartProcPhase(mark);
+#endif
 		NodePtrArr &order = curProc->revOrdering;
 
 		order.Init(curProc->size);
 
 		assert(curProc->exitNode);
 		curProc->exitNode->SetRevOrder(order);
+#ifdef GETSTATS
+		EndProcPhase(curProc, SetTimeStampsPhase, mark);
+#endif
 	}	
 }
+
+void Graphs::SetRevTimeStamps(ProcHeader* curProc)
+{
+	int time = 1;
+	NodePtrArr &order = curProc->Ordering;
+
+	// set the reverse parenthesis for the nodes
+	curProc->cfg->SetRevLoopStamps(time);
+
+	// copy both sets of parenthesis into contiguous columns indexed by order. The
+	// four columns share the one allocation.
+	StampCols &cols = curProc->stamps;
+	if (!cols.loopIn)
+	{
+		cols.loopIn = new int[order.Size() * 4];
+		cols.loopOut = cols.loopIn + order.Size();
+		cols.revIn = cols.loopOut + order.Size();
+		cols.revOut = cols.revIn + order.Size();
+	}
+	for (int i = 0; i < order.Size(); i++)
+		order[i]->CopyStamps(cols);
+}
@@ -0,0 +1,194 @@
+/*
+ * Copyright (C) 1997, Doug Simon
+ *
+ * See the file "LICENSE.TERMS" for information on usage and
+ * redistribution of this file, and for a DISCLAIMER OF ALL
+ * WARRANTIES.
+ *
+ */
+
+//File: GraphsDiff.cpp
+//Author: Doug Simon
+//Purpose: gives the implementation of the differential structuring mode. Each CFG is
+//	structured with the parenthesis theory and the interval theory algorithms and the
+//	time, memory and decisions of both are recorded. The algorithm selected on the
+//	command line is run last so that its decisions are the ones used to generate code.
+
+#include "MemAdvise.h"
+
+// the structuring decisions made for a node
+struct StructDecision {
+	structType sType;
+	CFGNode const* loopHead;
+	CFGNode const* latch;			// only set for loop headers
+	loopType lType;					// only set for loop headers
+	CFGNode const* loopFollow;		// only set for loop headers
+	condType cType;					// only set for conditional headers
+	CFGNode const* condFollow;		// only set for conditional headers
+	unstructType usType;				// only set for conditional headers that aren't cases
+};
+
+static char const* Structurer2String(structurer alg)
+{
+	return (alg == Parens ? "parens" : "intervals");
+}
+
+//*********************************************************************
+// Record the structuring decisions made for each node in order
+//*********************************************************************
+static void GetDecisions(NodePtrArr const &order, StructDecision* dec)
+{
+	for (int i = 0; i < order.Size(); i++)
+	{
+		CFGNode* curNode = order[i];
+		StructDecision &d = dec[i];
+
+		d.sType = curNode->GetStructType();
+		d.loopHead = curNode->GetLoopHead();
+		d.latch = d.loopFollow = d.condFollow = NULL;
+		d.lType = Endless;
+		d.cType = IfThenElse;
+		d.usType = Structured;
+
+		if (d.sType == Loop || d.sType == LoopCond)
+		{
+			d.latch = curNode->GetLatchNode();
+			d.lType = curNode->GetLoopType();
+			d.loopFollow = curNode->GetLoopFollow();
+		}
+		if (d.sType == Cond || d.sType == LoopCond)
+		{
+			d.cType = curNode->GetCondType();
+			d.condFollow = curNode->GetCondFollow();
+			if (d.cType != Case)
+				d.usType = curNode->GetUnstructType();
+		}
+	}
+}
+
+void Graphs::DiffStructure(ProcHeader* curProc)
+// Pre: the derived sequence for curProc has been built
+// Post: curProc has been structured with the selected algorithm and curProc->diff
+//		  holds the differences between the two algorithms
+{
+	NodePtrArr const &order = curProc->Ordering;
+	StructDecision* dec[2];
+	StructDiff* diff = new StructDiff;
+	structurer algs[2];
+	int i;
+
+	// structure with the other algorithm first
+	algs[1] = options.structAlg;
+	algs[0] = (algs[1] == Parens ? Intervals : Parens);
+
+	dec[0] = new StructDecision[order.Size()];
+	dec[1] = new StructDecision[order.Size()];
+	for (int a = 0; a < 2; a++)
+	{
+		structurer alg = algs[a];
+		double t[3] = {0,0,0};
+
+		if (a == 1)
+			for (i = 0; i < order.Size(); i++)
+				order[i]->ResetStructInfo();
+
+		dtime(t);
+		long mem = MemInUse();
+		StructureProc(curProc, alg);
+		dtime(t);
+		diff->time[alg] = t[1];
+		diff->mem[alg] = MemInUse() - mem;
+
+		// the derived sequence is part of the cost of the interval algorithm
+		if (alg == Intervals)
+		{
+			diff->time[alg] += curProc->derSeqTime;
+			diff->mem[alg] += curProc->derSeqMem;
+		}
+
+		GetDecisions(order, dec[a]);
+		diff->numLoops[alg] = diff->numGotos[alg] = 0;
+		for (i = 0; i < order.Size(); i++)
+		{
+			if (dec[a][i].latch)
+				diff->numLoops[alg]++;
+			if (dec[a][i].usType != Structured)
+				diff->numGotos[alg]++;
+		}
+	}
+
+	// compare the decisions made for each node. The nodes are the same for both
+	// algorithms so a node is referred to by its order.
+	diff->loopDiffs = diff->condDiffs = diff->gotoDiffs = 0;
+	for (i = 0; i < order.Size(); i++)
+	{
+		StructDecision &d0 = dec[0][i];
+		StructDecision &d1 = dec[1][i];
+		bool isLoop0 = (d0.sType == Loop || d0.sType == LoopCond);
+		bool isLoop1 = (d1.sType == Loop || d1.sType == LoopCond);
+		bool isCond0 = (d0.sType == Cond || d0.sType == LoopCond);
+		bool isCond1 = (d1.sType == Cond || d1.sType == LoopCond);
+
+		if (isLoop0 != isLoop1 || d0.loopHead != d1.loopHead || d0.latch != d1.latch ||
+			 d0.lType != d1.lType || d0.loopFollow != d1.loopFollow)
+			diff->loopDiffs++;
+		if (isCond0 != isCond1 || d0.cType != d1.cType || d0.condFollow != d1.condFollow)
+			diff->condDiffs++;
+		if (d0.usType != d1.usType)
+			diff->gotoDiffs++;
+	}
+
+	delete[] dec[0];
+	delete[] dec[1];
+	curProc->diff = diff;
+}
+
+//*********************************************************************
+// Display the differences between the two structuring algorithms
+//*********************************************************************
+void Graphs::DisplayDiffs()
+{
+	double time[2] = {0,0}, classTime[2][NUM_GRAPH_CLASSES];
+	int mem[2] = {0,0}, numDiffer = 0;
+	int c, a;
+
+	for (c = 0; c < NUM_GRAPH_CLASSES; c++)
+		classTime[Parens][c] = classTime[Intervals][c] = 0.0;
+
+	cout << "Structurer differences (procedure: time, memory, loops, jumps for parens / intervals;";
+	cout << " nodes whose loop, conditional and jump decisions differ):" << endl;
+	for (ProcHeader* curProc = procs; curProc; curProc = curProc->next)
+	{
+		StructDiff* diff = curProc->diff;
+		assert(diff);
+
+		cout << "\t" << curProc->name << " (" << GraphClass2String(curProc->cls) << "): ";
+		cout << diff->time[Parens] << " / " << diff->time[Intervals] << ", ";
+		cout << diff->mem[Parens] << " / " << diff->mem[Intervals] << ", ";
+		cout << diff->numLoops[Parens] << " / " << diff->numLoops[Intervals] << ", ";
+		cout << diff->numGotos[Parens] << " / " << diff->numGotos[Intervals] << "; ";
+		cout << diff->loopDiffs << ", " << diff->condDiffs << ", " << diff->gotoDiffs << endl;
+
+		for (a = 0; a < 2; a++)
+		{
+			time[a] += diff->time[a];
+			mem[a] += diff->mem[a];
+			classTime[a][curProc->cls] += diff->time[a];
+		}
+		if (diff->loopDiffs || diff->condDiffs || diff->gotoDiffs)
+			numDiffer++;
+	}
+
+	for (a = 0; a < 2; a++)
+	{
+		cout << "\t " << Structurer2String((structurer)a) << ": time = " << time[a];
+		cout << ", memory = " << mem[a] << endl;
+		for (c = 0; c < NUM_GRAPH_CLASSES; c++)
+		{
+			cout << "\t\t time for " << GraphClass2String((graphClass)c) << " CFG's = ";
+			cout << classTime[a][c] << endl;
+		}
+	}
+	cout << "\t # procedures structured differently = " << numDiffer << endl;
+	cout << "\t decisions used for code generation = " << Structurer2String(options.structAlg) << endl;
+}
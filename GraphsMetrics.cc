@@ -0,0 +1,222 @@
+/*
+ * Copyright (C) 1997, Doug Simon
+ *
+ * See the file "LICENSE.TERMS" for information on usage and
+ * redistribution of this file, and for a DISCLAIMER OF ALL
+ * WARRANTIES.
+ *
+ */
+
+//File: GraphsMetrics.cc
+//Author: Doug Simon
+//Purpose: gives the implementation of the metrics gathered for each procedure and of
+//	the table they are written to, so that the procedures that take the most time and
+//	memory can be found
+
+#include <fstream.h>
+#include <stdlib.h>
+#include "MemAdvise.h"
+#include "Stats.h"
+#include "Perf.h"
+#include "Trace.h"
+#include "StringFunctions.h"
+
+// the phases that are measured for each procedure, in the order they are written
+static toolPhase const procPhases[] = { SplitNodesPhase, SetTimeStampsPhase, DerSeqPhase,
+	ClassifyPhase, StructurePhase, CodeGenPhase };
+
+#define NUM_PROC_PHASES (int)(sizeof(procPhases) / sizeof(procPhases[0]))
+
+// the time taken by a procedure and its index in the list of procedures
+struct ProcTime {
+	double time;
+	int index;
+};
+
+// order procedures by decreasing time
+static int CmpProcTime(void const* a, void const* b)
+{
+	double ta = ((ProcTime const*)a)->time;
+	double tb = ((ProcTime const*)b)->time;
+	if (ta != tb)
+		return ta > tb ? -1 : 1;
+	return ((ProcTime const*)a)->index - ((ProcTime const*)b)->index;
+}
+
+void Graphs::StartProcPhase(ProcMark &mark)
+{
+	if (options.perfCounters)
+		PerfRead(mark.perf);
+	mark.wall = WallTime();
+	mark.mem = MemAllocated();
+}
+
+void Graphs::EndProcPhase(ProcHeader* curProc, toolPhase p, ProcMark const &mark)
+{
+	curProc->phaseTime[p] += WallTime() - mark.wall;
+	curProc->phaseMem[p] += MemAllocated() - mark.mem;
+	if (options.perfCounters)
+	{
+		long long perf[NUM_PERF_EVENTS];
+		PerfRead(perf);
+		for (int e = 0; e < NUM_PERF_EVENTS; e++)
+			curProc->perf[e] += perf[e] - mark.perf[e];
+	}
+	TraceEnd(PhaseName[p], curProc->name, mark.wall);
+}
+
+double Graphs::ProcTotalTime(ProcHeader const* curProc)
+{
+	double time = 0.0;
+	for (int p = 0; p < NUM_PROC_PHASES; p++)
+		time += curProc->phaseTime[procPhases[p]];
+	return time;
+}
+
+// write a name as a field of the CSV table, quoting it if it needs to be
+static void WriteCSVName(ofstream &out, char const* name)
+{
+	char const* p;
+	for (p = name; *p && *p != ',' && *p != '"' && *p != '\n'; p++)
+		;
+	if (!*p)
+	{
+		out << name;
+		return;
+	}
+	out << '"';
+	for (p = name; *p; p++)
+		if (*p == '"')
+			out << "\"\"";
+		else
+			out << *p;
+	out << '"';
+}
+
+void Graphs::WriteProcStats(char* fname)
+// The CSV table has a header row naming the columns. Each JSON Lines record holds the
+// same fields with the times and memory of the phases as objects keyed by phase.
+{
+	bool csv = (options.procStats == CSVProcStats);
+	char* name = concatstr(fname, csv ? ".procs.csv" : ".procs.jsonl");
+	ofstream out(name);
+
+	//make sure file was successfully opened
+	if (!out)
+	{
+		cerr << "Error: could not open output file." << endl;
+		exit(1);
+	}
+
+	int p;
+	if (csv)
+	{
+		out << "proc,class,instructions,nodes,edges,loops,2ways,nways,gotos,contBrks,maxIndent";
+		for (p = 0; p < NUM_PROC_PHASES; p++)
+			out << ',' << PhaseName[procPhases[p]] << "Time," << PhaseName[procPhases[p]] << "Mem";
+		out << ",totalTime";
+		if (options.perfCounters)
+			for (int e = 0; e < NUM_PERF_EVENTS; e++)
+				out << ',' << PerfEventName[e];
+		out << endl;
+	}
+
+	for (ProcHeader* curProc = procs; curProc; curProc = curProc->next)
+	{
+		NodePtrArr const &order = curProc->Ordering;
+		int numIns = 0, numEdges = 0;
+		for (int i = 0; i < order.Size(); i++)
+		{
+			numIns += order[i]->Instructions().Size();
+			numEdges += order[i]->GetOutEdges().Size();
+		}
+
+		if (csv)
+		{
+			WriteCSVName(out, curProc->name);
+			out << ',' << GraphClass2String(curProc->cls) << ',' << numIns << ',' <<
+				order.Size() << ',' << numEdges << ',' << curProc->numLoops << ',' <<
+				curProc->num2ways << ',' << curProc->numNways << ',' << curProc->numGotos <<
+				',' << curProc->numContBrks << ',' << curProc->maxIndent;
+			for (p = 0; p < NUM_PROC_PHASES; p++)
+				out << ',' << curProc->phaseTime[procPhases[p]] << ',' <<
+					curProc->phaseMem[procPhases[p]];
+			out << ',' << ProcTotalTime(curProc);
+			if (options.perfCounters)
+				for (int e = 0; e < NUM_PERF_EVENTS; e++)
+					out << ',' << curProc->perf[e];
+			out << endl;
+		}
+		else
+		{
+			char* procName = jsonstr(curProc->name);
+			out << "{\"proc\":" << procName;
+			delete[] procName;
+			out << ",\"class\":\"" << GraphClass2String(curProc->cls) << "\",\"instructions\":" <<
+				numIns << ",\"nodes\":" << order.Size() << ",\"edges\":" << numEdges <<
+				",\"loops\":" << curProc->numLoops << ",\"2ways\":" << curProc->num2ways <<
+				",\"nways\":" << curProc->numNways << ",\"gotos\":" << curProc->numGotos <<
+				",\"contBrks\":" << curProc->numContBrks << ",\"maxIndent\":" <<
+				curProc->maxIndent << ",\"time\":{";
+			for (p = 0; p < NUM_PROC_PHASES; p++)
+				out << (p ? ",\"" : "\"") << PhaseName[procPhases[p]] << "\":" <<
+					curProc->phaseTime[procPhases[p]];
+			out << "},\"memory\":{";
+			for (p = 0; p < NUM_PROC_PHASES; p++)
+				out << (p ? ",\"" : "\"") << PhaseName[procPhases[p]] << "\":" <<
+					curProc->phaseMem[procPhases[p]];
+			out << "},\"totalTime\":" << ProcTotalTime(curProc);
+			if (options.perfCounters)
+				for (int e = 0; e < NUM_PERF_EVENTS; e++)
+					if (PerfAvailable(e))
+						out << ",\"" << PerfEventName[e] << "\":" << curProc->perf[e];
+			out << '}' << endl;
+		}
+	}
+
+	if (!out)
+	{
+		cerr << "Error: could not write to " << name << "." << endl;
+		exit(1);
+	}
+	delete[] name;
+}
+
+void Graphs::DisplaySlowest(int n)
+{
+	int numProcs = 0;
+	ProcHeader* curProc;
+	for (curProc = procs; curProc; curProc = curProc->next)
+		numProcs++;
+
+	ProcHeader** byIndex = new ProcHeader*[numProcs];
+	ProcTime* times = new ProcTime[numProcs];
+	int i = 0;
+	for (curProc = procs; curProc; curProc = curProc->next, i++)
+	{
+		byIndex[i] = curProc;
+		times[i].time = ProcTotalTime(curProc);
+		times[i].index = i;
+	}
+	qsort(times, numProcs, sizeof(ProcTime), CmpProcTime);
+
+	if (n > numProcs)
+		n = numProcs;
+	cout << "\t the " << n << " slowest procedures:" << endl;
+	for (i = 0; i < n; i++)
+	{
+		curProc = byIndex[times[i].index];
+		cout << "\t\t" << curProc->name << " (" << GraphClass2String(curProc->cls) << ", " <<
+			curProc->Ordering.Size() << " nodes): " << times[i].time << " s";
+		for (int p = 0; p < NUM_PROC_PHASES; p++)
+			if (curProc->phaseTime[procPhases[p]] != 0.0)
+				cout << ", " << PhaseName[procPhases[p]] << " " << curProc->phaseTime[procPhases[p]];
+		if (PerfAvailable(CyclesEvent) && PerfAvailable(InstructionsEvent) &&
+			 curProc->perf[CyclesEvent] != 0)
+			cout << ", IPC " << (double)curProc->perf[InstructionsEvent] / curProc->perf[CyclesEvent];
+		cout << endl;
+	}
+
+	delete[] byIndex;
+	delete[] times;
+}
@@ -0,0 +1,285 @@
+/*
+ * Copyright (C) 1997, Doug Simon
+ *
+ * See the file "LICENSE.TERMS" for information on usage and
+ * redistribution of this file, and for a DISCLAIMER OF ALL
+ * WARRANTIES.
+ *
+ */
+
+//File: GraphsPST.cpp
+//Author: Doug Simon
+//Purpose: gives the implementation of the program structure tree of each cfg and of
+//	the structuring of its independent regions by more than one thread.
+//
+//	A single entry single exit region whose nodes aren't on any cycle can be structured
+//	without looking at the rest of the graph. Every path from one of its nodes to the
+//	exit leaves through its exit edge so FindImmedPDom gives each node the same post
+//	dominator whether it is run over the region alone or over the whole graph, and the
+//	later passes of FindImmedPDom leave it alone as none of its edges are back edges.
+//	The body of a case within the region ends at or before the node the region exits
+//	to, and any case enclosing the region comes later in the ordering, so StructConds
+//	can be run over the region by itself as well. The regions are structured first by
+//	the threads and the rest of the graph is structured as before, skipping the nodes
+//	already done, so the result is the same as structuring with one thread.
+
+#include <pthread.h>
+#include "MemAdvise.h"
+#include "Stats.h"
+#include "Trace.h"
+
+// the smallest procedure whose regions are structured by more than one thread. The
+// cost of starting the threads outweighs the work for anything smaller.
+#define MIN_THREADED_NODES 256
+
+// the work shared by the threads. The nodes of region r are byRevOrder[start[r]] to
+// byRevOrder[start[r + 1] - 1] in decreasing reverse order and are the same nodes of
+// byOrder in increasing order. The regions are handed out in order.
+struct Graphs::RegionWork {
+	Graphs* graphs;
+	char const* procName;		// the procedure the regions are in
+	int numRegions;
+	int* start;
+	CFGNode** byRevOrder;
+	CFGNode** byOrder;
+	int nextRegion;				// the next region to be handed out
+	pthread_mutex_t lock;		// protects nextRegion
+};
+
+//*********************************************************************
+// Build the program structure tree of a procedure
+//*********************************************************************
+void Graphs::BuildPST(ProcHeader* curProc)
+// Pre: every node of curProc reaches its exit node
+// Post: curProc->pst has been built. Its numRegions is -1 if the regions didn't nest.
+{
+	NodePtrArr const &order = curProc->Ordering;
+	CFGView cfg = {&order, curProc->cfg->Order()};
+	int exit = curProc->exitNode->Order();
+	int* edgeStart;
+	int* edgeClass;
+
+	PST* pst = new PST;
+	pst->regionOf = new int[order.Size()];
+
+	int numClasses = CycleEquivalence(cfg, exit, edgeStart, edgeClass);
+	pst->numRegions = StructureTree(cfg, exit, edgeStart, edgeClass, numClasses, pst->parent,
+		pst->regionOf);
+
+	delete[] edgeStart;
+	delete[] edgeClass;
+	curProc->pst = pst;
+
+#ifdef TESTPST
+	cerr << "Program structure tree for procedure " << curProc->name << endl;
+	cerr << "Region\tParent\tNodes" << endl;
+	for (int r = 0; r < pst->numRegions; r++)
+	{
+		cerr << r << "\t" << pst->parent[r] << "\t";
+		for (int i = 0; i < order.Size(); i++)
+			if (pst->regionOf[i] == r)
+				cerr << order[i]->Order() << ",";
+		cerr << endl;
+	}
+#endif
+}
+
+//*********************************************************************
+// Structure one region
+//*********************************************************************
+void Graphs::StructRegion(CFGNode** byRevOrder, CFGNode** byOrder, int numNodes)
+// Pre: byRevOrder and byOrder both hold all the nodes of a region that can be
+//		  structured on its own
+// NOTE: this is run by more than one thread at a time, each on its own region, so it
+//		  must only change the nodes of the region it is given
+{
+	int i, j;
+
+	// the first pass of FindImmedPDom over the region. The successors of a node are
+	// within the region or are the node the region exits to, and are all higher in the
+	// reverse graph as there are no cycles through the region.
+	for (i = 0; i < numNodes; i++)
+	{
+		CFGNode* curNode = byRevOrder[i];
+		NodePtrArr const &oEdges = curNode->GetOutEdges();
+		for (j = 0; j < oEdges.Size(); j++)
+			if (oEdges[j]->RevOrder() > curNode->RevOrder())
+				curNode->SetImmPDom(CommonPDom(curNode->GetImmPDom(), oEdges[j]));
+	}
+
+	// then StructConds over the region
+	for (i = 0; i < numNodes; i++)
+		if (byOrder[i]->GetOutEdges().Size() > 1)
+			StructCond(byOrder[i]);
+}
+
+void* Graphs::RegionWorker(void* arg)
+{
+	RegionWork* work = (RegionWork*)arg;
+
+	for (;;)
+	{
+		pthread_mutex_lock(&work->lock);
+		int r = work->nextRegion++;
+		pthread_mutex_unlock(&work->lock);
+
+		if (r >= work->numRegions)
+			break;
+		double start = TraceBegin();
+		work->graphs->StructRegion(work->byRevOrder + work->start[r], work->byOrder + work->start[r],
+			work->start[r + 1] - work->start[r]);
+		TraceEnd("StructRegion", work->procName, start);
+	}
+	return NULL;
+}
+
+//*********************************************************************
+// Structure the independent regions of a procedure with more than one
+// thread
+//*********************************************************************
+void Graphs::StructRegions(ProcHeader* curProc)
+// Pre: the reverse ordering of the nodes has been set and none have been structured
+// Post: curProc->preStructured marks the nodes that were structured (if any)
+{
+	NodePtrArr const &order = curProc->Ordering;
+	NodePtrArr const &revOrder = curProc->revOrdering;
+	int numNodes = order.Size();
+	int i, r;
+
+	// the regions are only well defined if every node reaches the exit
+	if (options.numThreads < 2 || numNodes < MIN_THREADED_NODES || revOrder.Size() != numNodes)
+		return;
+
+#ifdef GETSTATS
+	double t[3] = {0,0,0};
+	dtime(t);
+#endif
+
+	if (!curProc->pst)
+		BuildPST(curProc);
+	PST* pst = curProc->pst;
+	if (pst->numRegions == -1)
+		return;
+
+#ifdef GETSTATS
+	dtime(t);
+	stats.numRegions += pst->numRegions;
+	stats.pstTime += t[1];
+#endif
+
+	// a region can be structured on its own if none of its nodes is on a cycle. The
+	// size of a region includes the nodes of its subregions.
+	CFGView cfg = {&order, curProc->cfg->Order()};
+	int* comp = new int[numNodes];
+	int numComps = StrongComponents(cfg, comp);
+	int* compSize = new int[numComps];
+	bool* ok = new bool[pst->numRegions];
+	int* size = new int[pst->numRegions];
+
+	for (i = 0; i < numComps; i++)
+		compSize[i] = 0;
+	for (i = 0; i < numNodes; i++)
+		compSize[comp[i]]++;
+	for (r = 0; r < pst->numRegions; r++)
+	{
+		ok[r] = true;
+		size[r] = 0;
+	}
+	for (i = 0; i < numNodes; i++)
+	{
+		CFGNode* curNode = order[i];
+		r = pst->regionOf[i];
+		size[r]++;
+		if (compSize[comp[i]] > 1 || curNode->HasEdgeTo(curNode))
+			ok[r] = false;
+	}
+	for (r = pst->numRegions - 1; r > 0; r--)
+	{
+		size[pst->parent[r]] += size[r];
+		if (!ok[r])
+			ok[pst->parent[r]] = false;
+	}
+
+	// Hand out the largest regions that can be structured on their own and are small
+	// enough to keep each thread busy. The nodes of the regions that enclose them are
+	// left for the sequential passes, which then combine the results bottom up.
+	int maxSize = numNodes / (options.numThreads * 4);
+	int* unit = new int[pst->numRegions];
+	int numUnits = 0;
+	for (r = 0; r < pst->numRegions; r++)
+		if (r != 0 && unit[pst->parent[r]] != -1)
+			unit[r] = unit[pst->parent[r]];
+		else if (ok[r] && size[r] <= maxSize)
+			unit[r] = numUnits++;
+		else
+			unit[r] = -1;
+
+	if (numUnits != 0)
+	{
+		// sort the nodes of each unit into decreasing reverse order and into order
+		RegionWork work;
+		work.graphs = this;
+		work.procName = curProc->name;
+		work.numRegions = numUnits;
+		work.nextRegion = 0;
+		work.start = new int[numUnits + 1];
+		int* next = new int[numUnits];
+		for (i = 0; i <= numUnits; i++)
+			work.start[i] = 0;
+		for (i = 0; i < numNodes; i++)
+			if (unit[pst->regionOf[i]] != -1)
+				work.start[unit[pst->regionOf[i]] + 1]++;
+		for (i = 0; i < numUnits; i++)
+		{
+			work.start[i + 1] += work.start[i];
+			next[i] = work.start[i];
+		}
+		work.byRevOrder = new CFGNode*[work.start[numUnits]];
+		work.byOrder = new CFGNode*[work.start[numUnits]];
+		for (i = revOrder.Size() - 1; i >= 0; i--)
+		{
+			int u = unit[pst->regionOf[revOrder[i]->Order()]];
+			if (u != -1)
+				work.byRevOrder[next[u]++] = revOrder[i];
+		}
+		curProc->preStructured = new bool[numNodes];
+		for (i = 0; i < numUnits; i++)
+			next[i] = work.start[i];
+		for (i = 0; i < numNodes; i++)
+		{
+			int u = unit[pst->regionOf[i]];
+			curProc->preStructured[i] = (u != -1);
+			if (u != -1)
+				work.byOrder[next[u]++] = order[i];
+		}
+
+		// this thread does its share along with the ones it starts
+		int numStarted = 0;
+		pthread_t* threads = new pthread_t[options.numThreads - 1];
+		pthread_mutex_init(&work.lock, NULL);
+		for (i = 0; i < options.numThreads - 1; i++)
+			if (pthread_create(&threads[numStarted], NULL, RegionWorker, &work) == 0)
+				numStarted++;
+		RegionWorker(&work);
+		for (i = 0; i < numStarted; i++)
+			pthread_join(threads[i], NULL);
+		pthread_mutex_destroy(&work.lock);
+
+#ifdef GETSTATS
+		stats.numParRegions += numUnits;
+		stats.numParNodes += work.start[numUnits];
+#endif
+
+		delete[] threads;
+		delete[] work.start;
+		delete[] work.byRevOrder;
+		delete[] work.byOrder;
+		delete[] next;
+	}
+
+	delete[] comp;
+	delete[] compSize;
+	delete[] ok;
+	delete[] size;
+	delete[] unit;
+}
@@ -13,8 +13,14 @@
 //	algorithms
 
 #include <fstream.h>
+#include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
 #include "StringFunctions.h"
 #include "Options.h"
+#include "HLLEmitter.h"
+#include "Trace.h"
 
 extern Options options;
 
@@ -27,135 +33,415 @@ char* LoopString[3] = { "preTest", "postTest", "endless" };
 //an array used to find the string representation of a conditional type
 char* CondString[4] = { "if-then", "if-then-else", "if-else", "case" };
 
-void Graphs::GenerateGraphvizFile(char* fname)
+// the amount of graphviz output collected before it is written out. It is well short
+// of the size of the buffer so that the buffer never has to grow.
+#define DOT_FLUSH_SIZE (EMIT_INIT_SIZE / 2)
+
+// the work shared by the threads that write a file for each procedure. The procedures
+// are handed out in order and each thread takes one of the buffers.
+struct Graphs::DotWork {
+	Graphs* graphs;
+	int numProcs;
+	ProcHeader** procs;			// the procedures to be written
+	char** names;					// the name of the file of each procedure
+	DotView** views;				// the condensed view of each procedure (NULL if the
+										// nodes are all shown)
+	HLLEmitter** buffers;		// a buffer for each thread
+	int nextProc;					// the next procedure to be handed out
+	int nextBuffer;				// the next buffer to be handed out
+	char* failed;					// the first file that couldn't be written (NULL if none)
+	pthread_mutex_t lock;		// protects nextProc, nextBuffer and failed
+};
+
+// add the order of a node, counting from 1, or "(null)" if there is no node
+static void AddOrder(HLLEmitter &dot, CFGNode const* node)
+{
+	if (node)
+		dot.AddInt(node->Order() + 1);
+	else
+		dot.Add("(null)", 6);
+}
+
+bool Graphs::DotWanted(ProcHeader const* curProc) const
+{
+	if (options.dotProc && strcmp(curProc->name,options.dotProc) != 0)
+		return false;
+	return curProc->size >= options.dotMinSize;
+}
+
+// add the line of a node
+static void AddDotNode(HLLEmitter &dot, CFGNode const* curNode, char const* indent)
 {
-	ofstream outFile(concatstr(fname,".dot"));	//	
+	dot.Add(indent);
+	dot.AddInt(curNode->Ident());
+	dot.Add(" [shape=box");
+
+#ifdef CODEGEN
+	if (options.genCode)
+		// shade the nodes for code was not generated
+		if (curNode->Traversed() != DFS_CODEGEN)
+			dot.Add(",style=filled");
+#endif
+	//print the order of the node 
+	dot.Add(",label=\"");
+	dot.AddInt(curNode->Order() + 1);
+	
+	if (options.revOrder)
+	{
+		// print the order of the node in the reverse graph
+		dot.Add('(');
+		dot.AddInt(curNode->RevOrder() + 1);
+		dot.Add(')');
+	}
+
+	if (options.structInfo)
+	{
+		//print the structured type of the node plus any relevant extra information
+		dot.Add(':');
+		switch (curNode->GetStructType()){
+		case Seq:
+			dot.Add(StructString[curNode->GetStructType()]);
+			break;
+		case Cond:
+			dot.Add(CondString[curNode->GetCondType()]);
+			dot.Add("\\nCF:");
+			AddOrder(dot, curNode->GetCondFollow());
+			break;
+		case Loop:
+		case LoopCond:
+			dot.Add(LoopString[curNode->GetLoopType()]);
+			dot.Add("\\nLT:");
+			dot.AddInt(curNode->GetLatchNode()->Order() + 1);
+			dot.Add("\\nLF:");
+			AddOrder(dot, curNode->GetLoopFollow());
+			if (curNode->GetStructType() == LoopCond)
+			{
+				dot.Add("\\nCF:");
+				AddOrder(dot, curNode->GetCondFollow());
+			}
+			break;
+		}
+	}
+
+	if (options.showHeads)
+	{
+		// show the loop and case heads for each node
+		if (curNode->GetLoopHead())
+		{
+			dot.Add("\\nLH:");
+			dot.AddInt(curNode->GetLoopHead()->Order() + 1);
+		}
+		if (curNode->GetCaseHead())
+		{
+			dot.Add("\\nCH:");
+			dot.AddInt(curNode->GetCaseHead()->Order() + 1);
+		}
+	}
+#ifdef NUMBERINGS	
+	//print the two timestamp tuples for each node
+	dot.Add("\\n(");
+	dot.AddInt(curNode->loopStamps[0]);
+	dot.Add(',');
+	dot.AddInt(curNode->loopStamps[1]);
+	dot.Add(')');
+#endif
+
+	if (options.immPDom)
+	{
+		// print the immediate dominator info
+		if (curNode->GetImmPDom())
+		{
+			dot.Add("\\nImmPDom:");
+			dot.AddInt(curNode->GetImmPDom()->Order() + 1);
+		}
+		else
+			dot.Add("\\nImmPDom: -");
+	}
+
+	//finish off the node
+	dot.Add("\"];\n");
+}
+
+// add the line of the edge from a node along its out edge j
+static void AddDotEdge(HLLEmitter &dot, CFGNode const* curNode, int j, char const* indent)
+{
+	dot.Add(indent);
+	dot.AddInt(curNode->Ident());
+	dot.Add(" -> ");
+	dot.AddInt(curNode->GetOutEdges()[j]->Ident());
+	if (curNode->IsJumpToReturn())
+		dot.Add(" [style=dashed];\n");
+	else if (curNode->GetType() == cBranch && j == THEN)
+		dot.Add(" [style=bold];\n");
+	else
+		dot.Add(";\n");
+}
+
+bool Graphs::WriteDotProc(HLLEmitter &dot, int fd, ProcHeader const* curProc, DotView const* view,
+	char const* indent)
+{
+	NodePtrArr const &order = curProc->Ordering;
 	CFGNode* curNode;
-	ProcHeader* curProc; 
+	int i, j;
 
-	//make sure file was successfully opened
-	if (!outFile)
+	//write the procedure header node
+	dot.Add(indent);
+	dot.Add(curProc->name);
+	dot.Add(" [shape=diamond];\n");
+
+	//generate the entry for each node in this procedure that is shown
+	for (curNode = curProc->cfg, i = 0; curNode && i < curProc->size; i++,curNode = curNode->Next())
 	{
-		cerr << "Error: could not open " << strcat(fname,".dot") << " for writing." << endl;
-		exit(1);
+		if (dot.Size() >= DOT_FLUSH_SIZE && !dot.Flush(fd))
+			return false;
+		if (!view || view->Rep(curNode) == -1)
+			AddDotNode(dot, curNode, indent);
 	}
 
-	//write header information to file
-	outFile << "digraph ast {" << endl;
+	// then each summary node with the type of its header, the number of nodes and
+	// regions within it and its depth
+	for (i = 0; view && i < view->numRegions; i++)
+		if (view->summary[i])
+		{
+			if (dot.Size() >= DOT_FLUSH_SIZE && !dot.Flush(fd))
+				return false;
 
-	//write the info for the graph nodes
-	for (curProc = procs; curProc; curProc= curProc->next)
+			CFGNode const* header = view->header[i];
+			dot.Add(indent);
+			dot.Add('r');
+			dot.AddInt(header->Ident());
+			dot.Add(" [shape=box3d,label=\"");
+			dot.AddInt(header->Order() + 1);
+			dot.Add(':');
+			if (view->kind[i] == LoopRegion)
+				dot.Add(LoopString[header->GetLoopType()]);
+			else
+				dot.Add(CondString[header->GetCondType()]);
+			dot.Add("\\nnodes:");
+			dot.AddInt(view->size[i]);
+			dot.Add("\\nloops:");
+			dot.AddInt(view->nested[i * 3 + LoopRegion]);
+			dot.Add(" conds:");
+			dot.AddInt(view->nested[i * 3 + CondRegion]);
+			dot.Add(" cases:");
+			dot.AddInt(view->nested[i * 3 + CaseRegion]);
+			dot.Add("\\ndepth:");
+			dot.AddInt(view->depth[i]);
+			dot.Add("\"];\n");
+		}
+
+	//build the edge from the procedure block to the first node
+	dot.Add(indent);
+	dot.Add(curProc->name);
+	dot.Add(" -> ");
+	if (view && view->Rep(curProc->cfg) != -1)
 	{
-		int i;
-		//write the procedure header node
-		outFile << "\t" << curProc->name << " [shape=diamond];" << endl;
-	
-		//generate the entry for each node in this procedure
-		for (curNode = curProc->cfg, i = 0; curNode && i < curProc->size; i++,curNode = curNode->Next())
+		dot.Add('r');
+		dot.AddInt(view->header[view->Rep(curProc->cfg)]->Ident());
+	}
+	else
+		dot.AddInt(curProc->cfg->Ident());
+	dot.Add(";\n");
+
+	//build the rest of the edges between the nodes that are shown
+	for (curNode = curProc->cfg, i = 0; curNode && i < curProc->size; i++,curNode = curNode->Next())
+	{
+		NodePtrArr const &oEdges = curNode->GetOutEdges();
+		for (j = 0; j < oEdges.Size(); j++) 
 		{
-			outFile << "\t" << curNode->Ident() << " [shape=box";
+			if (dot.Size() >= DOT_FLUSH_SIZE && !dot.Flush(fd))
+				return false;
+			if (!view || (view->Rep(curNode) == -1 && view->Rep(oEdges[j]) == -1))
+				AddDotEdge(dot, curNode, j, indent);
+		}
+	}
 
-#ifdef CODEGEN
-			if (options.genCode)
-				// shade the nodes for code was not generated
-				if (curNode->Traversed() != DFS_CODEGEN)
-					outFile << ",style=filled";
-#endif
-			//print the order of the node 
-			outFile << ",label=\"" << curNode->Order() + 1;
-			
-			if (options.revOrder)
-			{
-				// print the order of the node in the reverse graph
-				outFile << "(" << curNode->RevOrder() + 1 << ")";
-			}
+	// and the edges to and from the summary nodes
+	for (i = 0; view && i < view->numEdges; i++)
+	{
+		if (dot.Size() >= DOT_FLUSH_SIZE && !dot.Flush(fd))
+			return false;
 
-			if (options.structInfo)
+		dot.Add(indent);
+		for (j = 0; j < 2; j++)
+		{
+			int end = view->edges[i * 2 + j];
+			if (end < 0)
 			{
-				//print the structured type of the node plus any relevant extra information
-				outFile << ":";
-				switch (curNode->GetStructType()){
-				case Seq:
-					outFile << StructString[curNode->GetStructType()];
-					break;
-				case Cond:
-					outFile << CondString[curNode->GetCondType()] << "\\nCF:";
-					if (curNode->GetCondFollow())
-						outFile << curNode->GetCondFollow()->Order() + 1;
-					else
-						outFile << "(null)";
-					break;
-				case Loop:
-					outFile << LoopString[curNode->GetLoopType()] << "\\nLT:";
-					outFile << curNode->GetLatchNode()->Order() + 1 << "\\nLF:";
-					if (curNode->GetLoopFollow())
-						outFile << curNode->GetLoopFollow()->Order() + 1;
-					else
-						outFile << "(null)";
-					break;
-				case LoopCond:
-					outFile << LoopString[curNode->GetLoopType()] << "\\nLT:";
-					outFile << curNode->GetLatchNode()->Order() + 1 << "\\nLF:";
-					if (curNode->GetLoopFollow())
-						outFile << curNode->GetLoopFollow()->Order() + 1;
-					else
-						outFile << "(null)";
-					outFile << "\\nCF:";
-					if (curNode->GetCondFollow())
-						outFile << curNode->GetCondFollow()->Order() + 1;
-					else
-						outFile << "(null)";
-					break;
-				}
+				dot.Add('r');
+				dot.AddInt(view->header[-end - 1]->Ident());
 			}
+			else
+				dot.AddInt(order[end]->Ident());
+			dot.Add(j == 0 ? " -> " : ";\n");
+		}
+	}
+	return true;
+}
 
-			if (options.showHeads)
-			{
-				// show the loop and case heads for each node
-				if (curNode->GetLoopHead())
-					outFile << "\\nLH:" << curNode->GetLoopHead()->Order() + 1;
-				if (curNode->GetCaseHead())
-					outFile << "\\nCH:" << curNode->GetCaseHead()->Order() + 1;
-			}
-#ifdef NUMBERINGS	
-			//print the two timestamp tuples for each node
-			outFile << "\\n(" << curNode->loopStamps[0] << "," << curNode->loopStamps[1] << ")";
-#endif
+void* Graphs::DotWorker(void* arg)
+{
+	DotWork* work = (DotWork*)arg;
+
+	pthread_mutex_lock(&work->lock);
+	HLLEmitter &dot = *work->buffers[work->nextBuffer++];
+	pthread_mutex_unlock(&work->lock);
+
+	for (;;)
+	{
+		pthread_mutex_lock(&work->lock);
+		int p = work->nextProc++;
+		pthread_mutex_unlock(&work->lock);
+
+		if (p >= work->numProcs)
+			break;
+		ProcHeader const* curProc = work->procs[p];
+
+		bool ok = false;
+		double start = TraceBegin();
+		int fd = open(work->names[p], O_WRONLY | O_CREAT | O_TRUNC, 0666);
+		if (fd != -1)
+		{
+			dot.Add("digraph \"");
+			dot.Add(curProc->name);
+			dot.Add("\" {\n");
+			ok = work->graphs->WriteDotProc(dot, fd, curProc, work->views[p], "\t");
+			dot.Add('}');
+			ok = dot.Flush(fd) && ok;
+			ok = (close(fd) == 0) && ok;
+		}
+		TraceEnd("output", curProc->name, start);
+		if (!ok)
+		{
+			pthread_mutex_lock(&work->lock);
+			if (!work->failed)
+				work->failed = work->names[p];
+			pthread_mutex_unlock(&work->lock);
+		}
+	}
+	return NULL;
+}
 
-			if (options.immPDom)
+void Graphs::GenerateGraphvizFile(char* fname)
+{
+	ProcHeader* curProc; 
+	int i;
+
+	if (options.dotMode == DotSplit)
+	{
+		// write the file of each procedure with the threads. The names of the files,
+		// the views and the buffers are made up front by this thread so that the
+		// threads only share the count of the procedures handed out.
+		DotWork work;
+		work.graphs = this;
+		work.numProcs = 0;
+		for (curProc = procs; curProc; curProc = curProc->next)
+			if (DotWanted(curProc))
+				work.numProcs++;
+		work.procs = new ProcHeader*[work.numProcs];
+		work.names = new char*[work.numProcs];
+		work.views = new DotView*[work.numProcs];
+		for (curProc = procs, i = 0; curProc; curProc = curProc->next)
+			if (DotWanted(curProc))
 			{
-				// print the immediate dominator info
-				if (curNode->GetImmPDom())
-					outFile << "\\nImmPDom:" << curNode->GetImmPDom()->Order() + 1;
-				else
-					outFile << "\\nImmPDom: -";
+				work.procs[i] = curProc;
+				work.names[i] = new char[strlen(fname) + strlen(curProc->name) + 6];
+				sprintf(work.names[i], "%s.%s.dot", fname, curProc->name);
+				work.views[i] = (options.dotDepth >= 0 ? CondenseProc(curProc, options.dotDepth) : NULL);
+				i++;
 			}
 
-			//finish off the node
-			outFile << "\"];" << endl;
+		int numThreads = options.numThreads;
+		if (numThreads > work.numProcs)
+			numThreads = (work.numProcs ? work.numProcs : 1);
+		work.buffers = new HLLEmitter*[numThreads];
+		for (i = 0; i < numThreads; i++)
+			work.buffers[i] = new HLLEmitter;
+		work.nextProc = 0;
+		work.nextBuffer = 0;
+		work.failed = NULL;
+
+		// this thread does its share along with the ones it starts
+		int numStarted = 0;
+		pthread_t* threads = new pthread_t[numThreads];
+		pthread_mutex_init(&work.lock, NULL);
+		for (i = 0; i < numThreads - 1; i++)
+			if (pthread_create(&threads[numStarted], NULL, DotWorker, &work) == 0)
+				numStarted++;
+		DotWorker(&work);
+		for (i = 0; i < numStarted; i++)
+			pthread_join(threads[i], NULL);
+		pthread_mutex_destroy(&work.lock);
+
+		if (work.failed)
+		{
+			cerr << "Error: could not write " << work.failed << endl;
+			exit(1);
+		}
+
+		for (i = 0; i < work.numProcs; i++)
+		{
+			delete[] work.names[i];
+			if (work.views[i])
+				delete work.views[i];
 		}
+		for (i = 0; i < numThreads; i++)
+			delete work.buffers[i];
+		delete[] threads;
+		delete[] work.procs;
+		delete[] work.names;
+		delete[] work.views;
+		delete[] work.buffers;
+		return;
+	}
 
-		//build the edge from the procedure block to the first node
-		outFile << "\t" << curProc->name << " -> " << curProc->cfg->Ident() << ";" << endl;
+	char* name = concatstr(fname,".dot");
+	int fd = open(name, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+	HLLEmitter dot;
+	bool ok = (fd != -1);
 
-		//build the rest of the edges
-		for (curNode = curProc->cfg, i = 0; curNode && i < curProc->size; i++,curNode = curNode->Next())
+	//make sure file was successfully opened
+	if (!ok)
+	{
+		cerr << "Error: could not open " << name << " for writing." << endl;
+		exit(1);
+	}
+
+	//write header information to file
+	dot.Add("digraph ast {\n");
+
+	//write the info for the graph nodes
+	for (curProc = procs; curProc && ok; curProc= curProc->next)
+		if (DotWanted(curProc))
 		{
-			NodePtrArr const &oEdges = curNode->GetOutEdges();
-     		for (int j = 0; j < oEdges.Size(); j++) 
+			double start = TraceBegin();
+			DotView* view = (options.dotDepth >= 0 ? CondenseProc(curProc, options.dotDepth) : NULL);
+			if (options.dotMode == DotClusters)
 			{
-				outFile << "\t" << curNode->Ident() << " -> " << oEdges[j]->Ident();
- 				if (curNode->IsJumpToReturn())
-					outFile << " [style=dashed];" << endl;
-				else if (curNode->GetType() == cBranch && j == THEN)
-					outFile << " [style=bold];" << endl;
-				else
-					outFile << ";" << endl;
+				// each procedure is a cluster labelled with its name
+				dot.Add("\tsubgraph \"cluster_");
+				dot.Add(curProc->name);
+				dot.Add("\" {\n\t\tlabel=\"");
+				dot.Add(curProc->name);
+				dot.Add("\";\n");
+				ok = WriteDotProc(dot, fd, curProc, view, "\t\t");
+				dot.Add("\t}\n");
 			}
+			else
+				ok = WriteDotProc(dot, fd, curProc, view, "\t");
+			if (view)
+				delete view;
+			TraceEnd("output", curProc->name, start);
 		}
-	}
+
 	//write the tailer to the file
-	outFile << "}";
+	dot.Add('}');
+	ok = ok && dot.Flush(fd);
 
-	outFile.close();
+	if (close(fd) != 0 || !ok)
+	{
+		cerr << "Error: could not write " << name << endl;
+		exit(1);
+	}
+	delete[] name;
 }	
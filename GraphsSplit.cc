@@ -0,0 +1,375 @@
+/*
+ * Copyright (C) 1997, Doug Simon
+ *
+ * See the file "LICENSE.TERMS" for information on usage and
+ * redistribution of this file, and for a DISCLAIMER OF ALL
+ * WARRANTIES.
+ *
+ */
+
+//File: GraphsSplit.cpp
+//Author: Doug Simon
+//Purpose: gives the implementation of controlled node splitting. The structuring
+//	algorithms assume a reducible graph and any jump into the middle of a loop ends
+//	up as a goto. An irreducible graph is made reducible by duplicating the nodes of
+//	a region that is entered from more than one place, one copy for each extra entry.
+
+#include "Options.h"
+
+extern Options options;
+
+//*********************************************************************
+// Return the region (i.e. the root) that node n has been merged into
+//*********************************************************************
+static int FindRegion(int* parent, int n)
+{
+	while (parent[n] != n)
+	{
+		parent[n] = parent[parent[n]];
+		n = parent[n];
+	}
+	return n;
+}
+
+//*********************************************************************
+// Return true if region r of the reduced graph lies on a cycle. Splitting a
+// region outside of every cycle would only add code. The reached and stack
+// arrays are work space.
+//*********************************************************************
+static bool OnCycle(int r, NodePtrArr const &nodes, int* idx, int* parent, int* members, 
+	int* reached, int* stack)
+{
+	int top = 0;
+	bool onCycle = false;
+
+	stack[top++] = r;
+	while (top != 0 && !onCycle)
+	{
+		int cur = stack[--top];
+		int m = cur;
+		do {
+			NodePtrArr const &oEdges = nodes[m]->GetOutEdges();
+			for (int i = 0; i < oEdges.Size(); i++)
+			{
+				int dest = FindRegion(parent, idx[oEdges[i]->Ident()]);
+				if (dest == r && cur != r)
+					onCycle = true;
+				else if (dest != r && reached[dest] != r)
+				{
+					reached[dest] = r;
+					stack[top++] = dest;
+				}
+			}
+			m = members[m];
+		} while (m != cur);
+	}
+	return onCycle;
+}
+
+//*********************************************************************
+// Split the nodes of each procedure
+//*********************************************************************
+void Graphs::SplitNodes()
+{
+	for (ProcHeader* curProc = procs; curProc; curProc = curProc->next)
+	{
+#ifdef GETSTATS
+		double t[3] = {0,0,0};
+		ProcMark mark;
+		dtime(t);
+		StartProcPhase(mark);
+#endif
+		int budget = options.splitBudget;
+
+		while (SplitRegion(curProc, budget))
+			;
+
+#ifdef GETSTATS
+		EndProcPhase(curProc, SplitNodesPhase, mark);
+		dtime(t);
+		curProc->splitTime = t[1];
+
+		stats.numSplitNodes += curProc->splitNodes;
+		stats.numSplitIns += curProc->splitIns;
+		stats.numSplitEntries += curProc->splitEntries;
+		if (curProc->irreducible)
+			stats.numIrreducible++;
+		stats.splitTime += t[1];
+#endif
+	}
+}
+
+bool Graphs::SplitRegion(ProcHeader* curProc, int &budget)
+{
+	NodePtrArr nodes;		// the nodes reachable from the procedure entry
+	NodePtrArr stack;
+	CFGNode* curNode;
+	int numEdges = 0;
+	int i, j, k;
+
+	// number the nodes reachable from the entry of the procedure. The entry is
+	// always numbered 0
+	int* idx = new int[nextId];
+	for (i = 0; i < nextId; i++)
+		idx[i] = -1;
+
+	idx[curProc->cfg->Ident()] = 0;
+	nodes.Add(curProc->cfg);
+	stack.Add(curProc->cfg);
+	while (stack.Size() != 0)
+	{
+		curNode = stack[stack.Size() - 1];
+		stack.RemoveLast();
+
+		NodePtrArr const &oEdges = curNode->GetOutEdges();
+		numEdges += oEdges.Size();
+		for (i = 0; i < oEdges.Size(); i++)
+			if (idx[oEdges[i]->Ident()] == -1)
+			{
+				idx[oEdges[i]->Ident()] = nodes.Size();
+				nodes.Add(oEdges[i]);
+				stack.Add(oEdges[i]);
+			}
+	}
+
+	int n = nodes.Size();
+
+	// Each region is a set of nodes with a single entry node (its root). A region
+	// keeps a list of the edges into any of its nodes (by the source of each edge)
+	// and a circular list of its member nodes.
+	int* parent = new int[n];
+	int* members = new int[n];
+	int* inHead = new int[n];
+	int* inTail = new int[n];
+	int* edgeSrc = new int[numEdges];
+	int* edgeNext = new int[numEdges];
+
+	for (i = 0; i < n; i++)
+	{
+		parent[i] = members[i] = i;
+		inHead[i] = inTail[i] = -1;
+	}
+
+	k = 0;
+	for (i = 0; i < n; i++)
+	{
+		NodePtrArr const &oEdges = nodes[i]->GetOutEdges();
+		for (j = 0; j < oEdges.Size(); j++, k++)
+		{
+			int dest = idx[oEdges[j]->Ident()];
+
+			edgeSrc[k] = i;
+			edgeNext[k] = -1;
+			if (inHead[dest] == -1)
+				inHead[dest] = k;
+			else
+				edgeNext[inTail[dest]] = k;
+			inTail[dest] = k;
+		}
+	}
+
+	// Reduce the graph. Self edges are ignored (T1) and a region with a single
+	// predecessor is merged into that predecessor (T2).
+	int numRegions = n;
+	bool changed = true;
+	while (changed)
+	{
+		changed = false;
+		for (i = 1; i < n; i++)
+			if (parent[i] == i)
+			{
+				int pred = -1;
+				for (k = inHead[i]; k != -1; k = edgeNext[k])
+				{
+					j = FindRegion(parent, edgeSrc[k]);
+					if (j == i)
+						continue;
+					if (pred == -1)
+						pred = j;
+					else if (j != pred)
+						break;
+				}
+
+				if (k == -1)
+				{
+					assert(pred != -1);
+					parent[i] = pred;
+
+					// append the in edges and the members of this region onto its predecessor
+					if (inHead[pred] == -1)
+						inHead[pred] = inHead[i];
+					else
+						edgeNext[inTail[pred]] = inHead[i];
+					inTail[pred] = inTail[i];
+
+					j = members[pred];
+					members[pred] = members[i];
+					members[i] = j;
+
+					numRegions--;
+					changed = true;
+				}
+			}
+	}
+
+	bool split = false;
+	curProc->irreducible = (numRegions != 1);
+
+	if (curProc->irreducible)
+	{
+		// The graph is irreducible. Find the region on a cycle whose duplication
+		// costs the least instructions in total. The entry region, a region holding
+		// the exit node and a region holding another procedure's entry can't be
+		// duplicated.
+		int* seen = new int[n];
+		int* reached = new int[n];
+		int* work = new int[n];
+		for (i = 0; i < n; i++)
+			seen[i] = reached[i] = -1;
+
+		int best = -1, bestCost = 0, bestPreds = 0, bestSize = 0;
+		for (i = 1; i < n; i++)
+			if (parent[i] == i)
+			{
+				int numPreds = 0;
+				for (k = inHead[i]; k != -1; k = edgeNext[k])
+				{
+					j = FindRegion(parent, edgeSrc[k]);
+					if (j != i && seen[j] != i)
+					{
+						seen[j] = i;
+						numPreds++;
+					}
+				}
+
+				int size = 0;
+				bool canCopy = true;
+				j = i;
+				do {
+					if (nodes[j] == curProc->exitNode || nodes[j]->GetProcLabel())
+						canCopy = false;
+					size += nodes[j]->Instructions().Size();
+					j = members[j];
+				} while (j != i);
+
+				int cost = size * (numPreds - 1);
+				if (canCopy && numPreds > 1 && (best == -1 || cost < bestCost) &&
+					OnCycle(i, nodes, idx, parent, members, reached, work))
+				{
+					best = i;
+					bestCost = cost;
+					bestPreds = numPreds;
+					bestSize = size;
+				}
+			}
+
+		if (best != -1 && bestCost <= budget)
+		{
+			CFGNode** copyOf = new CFGNode*[n];
+
+			// the first predecessor keeps the original region and each of the others
+			// gets a copy of its own
+			for (i = 0; i < n; i++)
+				seen[i] = -1;
+			bool first = true;
+			for (k = inHead[best]; k != -1; k = edgeNext[k])
+			{
+				int pred = FindRegion(parent, edgeSrc[k]);
+				if (pred == best || seen[pred] == best)
+					continue;
+				seen[pred] = best;
+				if (first)
+				{
+					first = false;
+					continue;
+				}
+
+				// duplicate the members of the region, inserting the copies into the
+				// list of nodes for this procedure
+				j = best;
+				do {
+					copyOf[j] = new CFGNode(nextId++, *nodes[j]);
+					copyOf[j]->SetNext(curProc->cfg->Next());
+					curProc->cfg->SetNext(copyOf[j]);
+					if (tail == curProc->cfg)
+						tail = copyOf[j];
+					curProc->size++;
+					curProc->splitNodes++;
+					j = members[j];
+				} while (j != best);
+
+				// give the copies the same edges as the originals, except that edges
+				// within the region stay within the copy
+				j = best;
+				do {
+					NodePtrArr const &oEdges = nodes[j]->GetOutEdges();
+					for (i = 0; i < oEdges.Size(); i++)
+					{
+						int dest = idx[oEdges[i]->Ident()];
+						if (FindRegion(parent, dest) == best)
+							copyOf[j]->AddEdgeTo(copyOf[dest]);
+						else
+							copyOf[j]->AddEdgeTo(oEdges[i]);
+					}
+					j = members[j];
+				} while (j != best);
+
+				// make the predecessor enter the copy instead of the original
+				j = pred;
+				do {
+					nodes[j]->RedirectEdges(nodes[best], copyOf[best]);
+					j = members[j];
+				} while (j != pred);
+
+				curProc->splitIns += bestSize;
+				curProc->splitEntries++;
+			}
+			assert(curProc->splitEntries > 0 && bestPreds > 1);
+
+			budget -= bestCost;
+			split = true;
+			delete[] copyOf;
+		}
+		delete[] seen;
+		delete[] reached;
+		delete[] work;
+	}
+
+	delete[] idx;
+	delete[] parent;
+	delete[] members;
+	delete[] inHead;
+	delete[] inTail;
+	delete[] edgeSrc;
+	delete[] edgeNext;
+
+	return split;
+}
+
+//*********************************************************************
+// Display the results of splitting the nodes of each procedure
+//*********************************************************************
+void Graphs::DisplaySplits()
+{
+#ifdef GETSTATS
+	cout << "\t node splitting (budget = " << options.splitBudget << " instructions per procedure):" << endl;
+	for (ProcHeader* curProc = procs; curProc; curProc = curProc->next)
+		if (curProc->splitNodes != 0 || curProc->irreducible)
+		{
+			cout << "\t\t" << curProc->name << ": " << curProc->splitNodes << " nodes (";
+			cout << curProc->splitIns << " instructions) duplicated, " << curProc->splitEntries;
+			cout << " irreducible entries removed, ";
+			if (options.genCode)
+				cout << curProc->numGotos << " goto's generated, ";
+			cout << "time = " << curProc->splitTime;
+			if (curProc->irreducible)
+				cout << " (still irreducible)";
+			cout << endl;
+		}
+	cout << "\t # nodes duplicated = " << stats.numSplitNodes << endl;
+	cout << "\t # instructions duplicated = " << stats.numSplitIns << endl;
+	cout << "\t # irreducible entries removed = " << stats.numSplitEntries << endl;
+	cout << "\t # graphs still irreducible = " << stats.numIrreducible << endl;
+	cout << "\t time to split nodes = " << stats.splitTime << endl;
+#endif
+}
@@ -0,0 +1,395 @@
+/*
+ * Copyright (C) 1997, Doug Simon
+ *
+ * See the file "LICENSE.TERMS" for information on usage and
+ * redistribution of this file, and for a DISCLAIMER OF ALL
+ * WARRANTIES.
+ *
+ */
+
+//File: GraphsView.cc
+//Author: Doug Simon
+//Purpose: gives the implementation of the Graphs's operations that condense the graph of
+//	a procedure into its structured regions for the graphviz output (--dot-depth).
+//
+//	There is a region for each loop header, each case header and each other conditional
+//	header that has a follow. The members of a loop are found from the loop head of each
+//	node. The members of a conditional or case are the nodes reached from its header
+//	without going through its follow, along a back edge or out of the loop that holds the
+//	header. A loop nested in a conditional is stepped over to its follow and counted
+//	whole, as is a nested conditional or case that has already been walked, so that
+//	the regions are walked in time linear in the size of the graph when they nest.
+//
+//	The regions don't always nest in an unstructured graph, so each node is taken to be
+//	in the smallest region that holds it and each region to be nested in the smallest
+//	larger region that holds its header. This always gives a tree.
+
+#include <stdlib.h>
+
+// the kinds of region
+enum regionKind {
+	LoopRegion,
+	CondRegion,
+	CaseRegion
+};
+
+// the graph of a procedure with its regions. The regions are numbered in order of
+// their headers. A region nested more than the depth limit is shown by the outermost
+// such region that holds it, which is one of the summary nodes of the view.
+struct Graphs::DotView {
+	int numNodes;
+	int numRegions;
+	CFGNode const** header;	// the header of each region
+	char* kind;					// the regionKind of each region
+	int* size;					// the number of nodes in each region
+	int* depth;					// the nesting depth of each region (1 for the outermost)
+	int* nested;				// the number of regions of each kind nested in each region
+									// (three for each region indexed by kind)
+	bool* summary;				// is the region shown as a summary node?
+	int* rep;					// the summary region shown in place of each node by order
+									// (-1 if the node is shown itself)
+	int numEdges;				// the edges to and from the summary nodes
+	int* edges;					// the two ends of each of these edges. An end is the order
+									// of a node or -(r + 1) for region r.
+
+	DotView() : header(NULL), kind(NULL), size(NULL), depth(NULL), nested(NULL),
+		summary(NULL), rep(NULL), edges(NULL) {}
+
+	// return the summary region shown in place of a node (-1 if it is shown itself)
+	int Rep(CFGNode const* node) const
+	{
+		int o = node->Order();
+		return (o >= 0 && o < numNodes ? rep[o] : -1);
+	}
+
+	~DotView()
+	{
+		delete[] header;
+		delete[] kind;
+		delete[] size;
+		delete[] depth;
+		delete[] nested;
+		delete[] summary;
+		delete[] rep;
+		delete[] edges;
+	}
+};
+
+// the order of region r in the ordering of the regions by their size. Larger regions
+// come later and regions of the same size are ordered by their number.
+static inline bool KeyBefore(int const* size, int r, int s)
+{
+	return size[r] < size[s] || (size[r] == size[s] && r < s);
+}
+
+// return the loop region headed by the loop head of a node (-1 if none)
+static inline int LoopOf(CFGNode const* node, int const* regionOf, char const* kind)
+{
+	CFGNode const* loopHead = node->GetLoopHead();
+	if (!loopHead || regionOf[loopHead->Order()] == -1 ||
+		kind[regionOf[loopHead->Order()]] != LoopRegion)
+		return -1;
+	return regionOf[loopHead->Order()];
+}
+
+static int const* sortSize;	// the sizes the regions are sorted by
+
+static int CmpRegion(void const* a, void const* b)
+{
+	int r = *(int const*)a;
+	int s = *(int const*)b;
+	return (KeyBefore(sortSize, r, s) ? -1 : (r == s ? 0 : 1));
+}
+
+static int CmpEdge(void const* a, void const* b)
+{
+	int const* e = (int const*)a;
+	int const* f = (int const*)b;
+	if (e[0] != f[0])
+		return (e[0] < f[0] ? -1 : 1);
+	return (e[1] < f[1] ? -1 : (e[1] == f[1] ? 0 : 1));
+}
+
+//*********************************************************************
+// Walk a conditional or case region
+//*********************************************************************
+static int WalkCondRegion(int r, CFGNode const* h, int const* regionOf, char const* kind, int const* size, int* seen, CFGNode const** stack, int* best)
+// Pre: h is the header of the conditional or case region r. The sizes of the loops
+//		  and of the regions numbered before r are known. No entry of seen is r + 1.
+// Post: returns the number of nodes in the region. If best is given, best[n] has been
+//		  set to r for each node n in the region such that r comes before best[n] in the
+//		  ordering of the regions by their size (but not before the region of n itself).
+{
+	CFGNode const* follow = h->GetCondFollow();
+	CFGNode const* loopHead = h->GetLoopHead();
+	int count = 1;
+	int top = 0;
+
+	seen[h->Order()] = r + 1;
+	stack[top++] = h;
+	while (top)
+	{
+		CFGNode const* curNode = stack[--top];
+		int o = curNode->Order();
+
+		if (best && (best[o] == -1 || KeyBefore(size, r, best[o])) &&
+			(regionOf[o] == -1 || KeyBefore(size, regionOf[o], r)))
+			best[o] = r;
+
+		// A nested loop is counted whole and left by its follow, as is a nested
+		// conditional or case that has already been walked (one numbered before r).
+		int n = (curNode != h ? regionOf[o] : -1);
+		if (n != -1 && (kind[n] == LoopRegion || n < r))
+		{
+			count += size[n] - 1;
+			CFGNode const* succ = (kind[n] == LoopRegion ? curNode->GetLoopFollow() :
+				curNode->GetCondFollow());
+			if (succ && succ != follow && seen[succ->Order()] != r + 1 &&
+				succ->GetLoopHead() == loopHead)
+			{
+				seen[succ->Order()] = r + 1;
+				stack[top++] = succ;
+				count++;
+			}
+			continue;
+		}
+
+		NodePtrArr const &oEdges = curNode->GetOutEdges();
+		for (int i = 0; i < oEdges.Size(); i++)
+		{
+			// (the back edges are tested for directly as HasBackEdgeTo checks that the
+			// edge is there)
+			CFGNode const* succ = oEdges[i];
+			if (succ == follow || seen[succ->Order()] == r + 1 || succ == curNode ||
+				succ->IsAncestorOf(curNode) || succ->GetLoopHead() != loopHead)
+				continue;
+			seen[succ->Order()] = r + 1;
+			stack[top++] = succ;
+			count++;
+		}
+	}
+	return count;
+}
+
+//*********************************************************************
+// Condense the graph of a procedure into its regions
+//*********************************************************************
+Graphs::DotView* Graphs::CondenseProc(ProcHeader const* curProc, int maxDepth)
+// Pre: the graph of curProc has been structured
+// Post: the returned view shows each region nested maxDepth + 1 deep as a summary node
+//		  that stands for all the nodes within it
+{
+	NodePtrArr const &order = curProc->Ordering;
+	int numNodes = order.Size();
+	int i, j, r;
+
+	DotView* view = new DotView;
+	view->numNodes = numNodes;
+
+	// find the regions
+	int* regionOf = new int[numNodes];
+	int numRegions = 0;
+	for (i = 0; i < numNodes; i++)
+	{
+		structType s = order[i]->GetStructType();
+		if (s == Loop || s == LoopCond ||
+			(s == Cond && (order[i]->GetCondFollow() || order[i]->GetCondType() == Case)))
+			regionOf[i] = numRegions++;
+		else
+			regionOf[i] = -1;
+	}
+	view->numRegions = numRegions;
+	view->header = new CFGNode const*[numRegions];
+	view->kind = new char[numRegions];
+	view->size = new int[numRegions];
+	view->depth = new int[numRegions];
+	view->nested = new int[numRegions * 3];
+	view->summary = new bool[numRegions];
+	int* size = view->size;
+	char* kind = view->kind;
+	for (i = 0; i < numNodes; i++)
+		if ((r = regionOf[i]) != -1)
+		{
+			structType s = order[i]->GetStructType();
+			view->header[r] = order[i];
+			if (s == Loop || s == LoopCond)
+				kind[r] = LoopRegion;
+			else
+				kind[r] = (order[i]->GetCondType() == Case ? CaseRegion : CondRegion);
+			size[r] = 1;
+		}
+
+	// The size of a loop is its header, the nodes whose loop head it is and the sizes of
+	// the loops nested directly in it. The loops are put in an order with each after the
+	// loop it is nested in by walking up the loop heads from each loop. A loop head that
+	// leads back to a loop already on the walk is ignored.
+	int* parent = new int[numRegions];
+	int* state = new int[numRegions];
+	int* walk = new int[numRegions];
+	int* byNesting = new int[numRegions];
+	int numLoops = 0;
+	for (r = 0; r < numRegions; r++)
+	{
+		parent[r] = (kind[r] == LoopRegion ? LoopOf(view->header[r], regionOf, kind) : -1);
+		state[r] = 0;
+	}
+	for (i = 0; i < numNodes; i++)
+		if ((r = LoopOf(order[i], regionOf, kind)) != -1 &&
+			!(regionOf[i] != -1 && kind[regionOf[i]] == LoopRegion))
+			size[r]++;
+	for (r = 0; r < numRegions; r++)
+		if (kind[r] == LoopRegion && state[r] == 0)
+		{
+			int top = 0;
+			for (int l = r; l != -1 && state[l] != 2; l = parent[l])
+			{
+				if (state[l] == 1)
+				{
+					parent[walk[top - 1]] = -1;
+					break;
+				}
+				state[l] = 1;
+				walk[top++] = l;
+			}
+			while (top)
+			{
+				state[walk[--top]] = 2;
+				byNesting[numLoops++] = walk[top];
+			}
+		}
+	for (i = numLoops - 1; i >= 0; i--)
+		if (parent[byNesting[i]] != -1)
+			size[parent[byNesting[i]]] += size[byNesting[i]];
+
+	// then the sizes of the conditionals and cases
+	int* seen = new int[numNodes];
+	CFGNode const** stack = new CFGNode const*[numNodes];
+	for (i = 0; i < numNodes; i++)
+		seen[i] = 0;
+	for (r = 0; r < numRegions; r++)
+		if (kind[r] != LoopRegion)
+			size[r] = WalkCondRegion(r, view->header[r], regionOf, kind, size, seen, stack,
+				NULL);
+
+	// Find the smallest region that holds each node, leaving out its own region and the
+	// regions before it if it is a header. The smallest loop is the one of its loop
+	// head. The conditionals and cases are walked again to find the rest.
+	int* best = new int[numNodes];
+	for (i = 0; i < numNodes; i++)
+	{
+		int l = LoopOf(order[i], regionOf, kind);
+		best[i] = -1;
+		if (l != -1 && (regionOf[i] == -1 || KeyBefore(size, regionOf[i], l)))
+			best[i] = l;
+		seen[i] = 0;
+	}
+	for (r = 0; r < numRegions; r++)
+		if (kind[r] != LoopRegion)
+			WalkCondRegion(r, view->header[r], regionOf, kind, size, seen, stack, best);
+	for (r = 0; r < numRegions; r++)
+		parent[r] = best[view->header[r]->Order()];
+
+	// A region comes before the region it is nested in when they are ordered by size, so
+	// the depths are found from the largest region down and the nested regions are
+	// counted from the smallest up.
+	for (r = 0; r < numRegions; r++)
+		byNesting[r] = r;
+	sortSize = size;
+	qsort(byNesting, numRegions, sizeof(int), CmpRegion);
+	int* shownBy = walk;
+	for (i = numRegions - 1; i >= 0; i--)
+	{
+		r = byNesting[i];
+		view->depth[r] = (parent[r] == -1 ? 1 : view->depth[parent[r]] + 1);
+		if (view->depth[r] <= maxDepth)
+			shownBy[r] = -1;
+		else if (view->depth[r] == maxDepth + 1)
+			shownBy[r] = r;
+		else
+			shownBy[r] = shownBy[parent[r]];
+		view->summary[r] = (shownBy[r] == r);
+	}
+	// The sizes found by the walks are only used to order the regions. A region may be
+	// reached from a conditional by more than one path, so the nodes in each region are
+	// counted again by the region each node is in.
+	int* count = state;
+	for (r = 0; r < numRegions; r++)
+		count[r] = 0;
+	for (i = 0; i < numNodes; i++)
+		if ((r = (regionOf[i] != -1 ? regionOf[i] : best[i])) != -1)
+			count[r]++;
+	for (i = 0; i < numRegions * 3; i++)
+		view->nested[i] = 0;
+	for (i = 0; i < numRegions; i++)
+	{
+		r = byNesting[i];
+		if (parent[r] != -1)
+		{
+			for (j = 0; j < 3; j++)
+				view->nested[parent[r] * 3 + j] += view->nested[r * 3 + j];
+			view->nested[parent[r] * 3 + kind[r]]++;
+			count[parent[r]] += count[r];
+		}
+	}
+	for (r = 0; r < numRegions; r++)
+		size[r] = count[r];
+
+	// each node is shown by the summary node of the region that holds it (if any)
+	view->rep = new int[numNodes];
+	for (i = 0; i < numNodes; i++)
+	{
+		r = (regionOf[i] != -1 ? regionOf[i] : best[i]);
+		view->rep[i] = (r == -1 ? -1 : shownBy[r]);
+	}
+
+	// the edges to and from the summary nodes, without the edges within a summary node
+	// and without duplicates
+	int numEdges = 0;
+	for (i = 0; i < numNodes; i++)
+	{
+		NodePtrArr const &oEdges = order[i]->GetOutEdges();
+		for (j = 0; j < oEdges.Size(); j++)
+		{
+			int from = view->rep[i];
+			int to = view->rep[oEdges[j]->Order()];
+			if ((from != -1 || to != -1) && from != to)
+				numEdges++;
+		}
+	}
+	view->edges = new int[numEdges * 2];
+	view->numEdges = 0;
+	for (i = 0; i < numNodes; i++)
+	{
+		NodePtrArr const &oEdges = order[i]->GetOutEdges();
+		for (j = 0; j < oEdges.Size(); j++)
+		{
+			int from = view->rep[i];
+			int to = view->rep[oEdges[j]->Order()];
+			if ((from != -1 || to != -1) && from != to)
+			{
+				int* e = view->edges + view->numEdges++ * 2;
+				e[0] = (from == -1 ? i : -(from + 1));
+				e[1] = (to == -1 ? oEdges[j]->Order() : -(to + 1));
+			}
+		}
+	}
+	qsort(view->edges, view->numEdges, 2 * sizeof(int), CmpEdge);
+	for (i = j = 0; i < view->numEdges; i++)
+		if (j == 0 || CmpEdge(view->edges + i * 2, view->edges + (j - 1) * 2) != 0)
+		{
+			view->edges[j * 2] = view->edges[i * 2];
+			view->edges[j * 2 + 1] = view->edges[i * 2 + 1];
+			j++;
+		}
+	view->numEdges = j;
+
+	delete[] regionOf;
+	delete[] parent;
+	delete[] state;
+	delete[] walk;
+	delete[] byNesting;
+	delete[] seen;
+	delete[] stack;
+	delete[] best;
+	return view;
+}
@@ -0,0 +1,336 @@
+/*
+ * Copyright (C) 1997, Doug Simon
+ *
+ * See the file "LICENSE.TERMS" for information on usage and
+ * redistribution of this file, and for a DISCLAIMER OF ALL
+ * WARRANTIES.
+ *
+ */
+
+//File: HLLEmitter.cc
+//Author: Doug Simon
+//Purpose: provides the implementation of the HLLEmitter class
+
+#include <stdlib.h>
+#include <limits.h>
+#include <errno.h>
+#include <assert.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#include "HLLEmitter.h"
+
+// the tab stops that are copied for each indentation
+static char const indentTable[MAX_INDENT_RUN + 1] =
+	"\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t"
+	"\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t";
+
+// order the labels by their offset and then by the order they were added
+int CmpLabel(const void* l1, const void* l2)
+{
+	HLLLabel const* a = (HLLLabel const*)l1;
+	HLLLabel const* b = (HLLLabel const*)l2;
+	if (a->offset != b->offset)
+		return a->offset - b->offset;
+	return a->seq - b->seq;
+}
+
+HLLEmitter::HLLEmitter(bool rem, int s) :
+	buf(new char[s]), sz(0), avail(s), labels(NULL), numLabels(0), labelsAvail(0),
+	slices(NULL), numSlices(0), slicesAvail(0), sliceBytes(0),
+	pieces(new struct iovec[EMIT_MAX_IOV]), numPieces(0), writeFailed(false), remGotos(rem), uses(NULL), usesAvail(0), procLabels(0), lastGoto(-1), cuts(NULL),
+	numCuts(0), cutsAvail(0), numRemoved(0) {}
+
+HLLEmitter::~HLLEmitter()
+{
+	delete[] buf;
+	if (labels)
+		delete[] labels;
+	if (slices)
+		delete[] slices;
+	delete[] pieces;
+	if (uses)
+		delete[] uses;
+	if (cuts)
+		delete[] cuts;
+}
+
+void HLLEmitter::Grow(int len)
+{
+	int newAvail = avail * 2;
+	while (newAvail < sz + len)
+		newAvail *= 2;
+
+	char* newBuf = new char[newAvail];
+	memcpy(newBuf, buf, sz);
+	delete[] buf;
+	buf = newBuf;
+	avail = newAvail;
+}
+
+void HLLEmitter::Indent(int indLevel)
+{
+	while (indLevel > MAX_INDENT_RUN)
+	{
+		Add(indentTable, MAX_INDENT_RUN);
+		indLevel -= MAX_INDENT_RUN;
+	}
+	Add(indentTable, indLevel);
+}
+
+void HLLEmitter::AddInt(int n)
+{
+	assert(n >= 0);
+
+	// the digits are formed from the right
+	char digits[12];
+	int i = sizeof(digits);
+	do {
+		digits[--i] = '0' + n % 10;
+		n /= 10;
+	} while (n);
+	Add(digits + i, sizeof(digits) - i);
+}
+
+void HLLEmitter::AddRef(char const* str, int len)
+{
+	if (numSlices == slicesAvail)
+	{
+		slicesAvail = (slicesAvail ? slicesAvail * 2 : 1024);
+		HLLSlice* newSlices = new HLLSlice[slicesAvail];
+		if (slices)
+		{
+			memcpy(newSlices, slices, numSlices * sizeof(HLLSlice));
+			delete[] slices;
+		}
+		slices = newSlices;
+	}
+	slices[numSlices].offset = sz;
+	slices[numSlices].str = str;
+	slices[numSlices].len = len;
+	numSlices++;
+	sliceBytes += len;
+}
+
+void HLLEmitter::AddLabelAt(int offset, int num)
+{
+	assert(offset >= 0 && offset <= sz);
+
+	if (numLabels == labelsAvail)
+	{
+		labelsAvail = (labelsAvail ? labelsAvail * 2 : 64);
+		HLLLabel* newLabels = new HLLLabel[labelsAvail];
+		if (labels)
+		{
+			memcpy(newLabels, labels, numLabels * sizeof(HLLLabel));
+			delete[] labels;
+		}
+		labels = newLabels;
+	}
+	labels[numLabels].offset = offset;
+	labels[numLabels].num = num;
+	labels[numLabels].seq = numLabels;
+	numLabels++;
+}
+
+void HLLEmitter::AddLabel(int num)
+{
+	if (!remGotos)
+	{
+		Add('L');
+		AddInt(num);
+		Add(":\n", 2);
+		return;
+	}
+
+	// if nothing but closing brackets (and other labels) have been added since a goto
+	// to this label then the goto just jumps to the next statement
+	if (lastGoto == num && gotoEnd == sz)
+	{
+		if (numCuts == cutsAvail)
+		{
+			cutsAvail = (cutsAvail ? cutsAvail * 2 : 64);
+			HLLCut* newCuts = new HLLCut[cutsAvail];
+			if (cuts)
+			{
+				memcpy(newCuts, cuts, numCuts * sizeof(HLLCut));
+				delete[] cuts;
+			}
+			cuts = newCuts;
+		}
+		cuts[numCuts].start = gotoStart;
+		cuts[numCuts].end = gotoStmtEnd;
+		numCuts++;
+		uses[num]--;
+		numRemoved++;
+		lastGoto = -1;
+	}
+	AddLabelAt(sz, num);
+}
+
+void HLLEmitter::AddGoto(int indLevel, int num)
+{
+	gotoStart = sz;
+	Indent(indLevel);
+	Add("goto L", 6);
+	AddInt(num);
+	Add(";\n", 2);
+
+	if (remGotos)
+	{
+		assert(num < usesAvail);
+		uses[num]++;
+		lastGoto = num;
+		gotoStmtEnd = gotoEnd = sz;
+	}
+}
+
+void HLLEmitter::CloseCond(int indLevel)
+{
+	int start = sz;
+	Indent(indLevel);
+	Add("}\n", 2);
+
+	if (lastGoto != -1 && gotoEnd == start)
+		gotoEnd = sz;
+}
+
+void HLLEmitter::StartProc(int numLabels)
+{
+	if (!remGotos)
+		return;
+
+	if (numLabels > usesAvail)
+	{
+		if (uses)
+			delete[] uses;
+		uses = new int[usesAvail = numLabels];
+	}
+	for (int i = 0; i < numLabels; i++)
+		uses[i] = 0;
+	procLabels = this->numLabels;
+	lastGoto = -1;
+}
+
+void HLLEmitter::EndProc()
+{
+	if (!remGotos)
+		return;
+
+	// drop the labels that no goto jumps to anymore
+	for (int i = procLabels; i < numLabels; i++)
+		if (uses[labels[i].num] == 0)
+			labels[i].num = -1;
+	lastGoto = -1;
+}
+
+void HLLEmitter::WritePieces(int fd)
+{
+	struct iovec* iov = pieces;
+	int n = numPieces;
+
+	// writev can write less than asked for so keep going from where it stopped
+	while (n && !writeFailed)
+	{
+		int len = writev(fd, iov, n);
+		if (len < 0)
+		{
+			if (errno != EINTR)
+				writeFailed = true;
+			continue;
+		}
+		while (n && len >= (int)iov->iov_len)
+		{
+			len -= iov->iov_len;
+			iov++;
+			n--;
+		}
+		if (n)
+		{
+			iov->iov_base = (char*)iov->iov_base + len;
+			iov->iov_len -= len;
+		}
+	}
+	numPieces = 0;
+}
+
+void HLLEmitter::AddPiece(int fd, char const* str, int len)
+{
+	if (len == 0)
+		return;
+
+	// a piece that carries on from the last one is joined to it
+	if (numPieces && (char const*)pieces[numPieces - 1].iov_base + pieces[numPieces - 1].iov_len == str)
+	{
+		pieces[numPieces - 1].iov_len += len;
+		return;
+	}
+	if (numPieces == EMIT_MAX_IOV)
+		WritePieces(fd);
+	pieces[numPieces].iov_base = (char*)str;
+	pieces[numPieces].iov_len = len;
+	numPieces++;
+}
+
+bool HLLEmitter::Flush(int fd)
+{
+	int codeEnd = sz;
+	int pos = 0;
+	int i = 0;
+	int j = 0;
+	int k = 0;
+
+	// form the text of the labels after the code so that the buffer doesn't move
+	// while it is being written out
+	if (numLabels)
+		qsort(labels, numLabels, sizeof(HLLLabel), CmpLabel);
+	for (i = 0; i < numLabels; i++)
+		if (labels[i].num != -1)
+		{
+			labels[i].text = sz;
+			Add('L');
+			AddInt(labels[i].num);
+			Add(":\n", 2);
+			labels[i].textLen = sz - labels[i].text;
+		}
+
+	// write out the code between each label, slice or removed goto and the next. At
+	// the same offset a label comes before a slice and a slice before a removed goto.
+	i = 0;
+	while (i < numLabels || j < numSlices || k < numCuts)
+	{
+		int labelAt = (i < numLabels ? labels[i].offset : INT_MAX);
+		int sliceAt = (j < numSlices ? slices[j].offset : INT_MAX);
+		int cutAt = (k < numCuts ? cuts[k].start : INT_MAX);
+
+		if (labelAt <= sliceAt && labelAt <= cutAt)
+		{
+			AddPiece(fd, buf + pos, labelAt - pos);
+			pos = labelAt;
+			if (labels[i].num != -1)
+				AddPiece(fd, buf + labels[i].text, labels[i].textLen);
+			i++;
+		}
+		else if (sliceAt <= cutAt)
+		{
+			AddPiece(fd, buf + pos, sliceAt - pos);
+			pos = sliceAt;
+			AddPiece(fd, slices[j].str, slices[j].len);
+			j++;
+		}
+		else
+		{
+			AddPiece(fd, buf + pos, cutAt - pos);
+			pos = cuts[k++].end;
+		}
+	}
+	AddPiece(fd, buf + pos, codeEnd - pos);
+	WritePieces(fd);
+
+	sz = 0;
+	numLabels = 0;
+	numSlices = 0;
+	sliceBytes = 0;
+	numCuts = 0;
+	procLabels = 0;
+	return !writeFailed;
+}
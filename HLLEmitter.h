@@ -0,0 +1,192 @@
+/*
+ * Copyright (C) 1997, Doug Simon
+ *
+ * See the file "LICENSE.TERMS" for information on usage and
+ * redistribution of this file, and for a DISCLAIMER OF ALL
+ * WARRANTIES.
+ *
+ */
+
+//File: HLLEmitter.h
+//Author: Doug Simon
+//Purpose: provides a class that collects the high level code of the procedures in
+//	one growable buffer and writes it out in large blocks. A label that is only
+//	found to be needed once the code after it has been emitted is recorded by its
+//	offset in the buffer and put in place when the buffer is written out.
+//
+//	Text that stays in place until the code is written out (such as the instructions,
+//	which point into the text of the input file) can be added by reference. It is
+//	recorded as a slice at its offset in the buffer and the buffer is written out with
+//	writev around the slices, so that the text is only copied once, into the file.
+//
+//	The emitter can also remove the goto's that aren't needed as the code is
+//	emitted. A goto is not needed if the only code between it and the label it jumps
+//	to closes conditionals, as control reaches the label anyway. The labels of a
+//	procedure are numbered by the order of their nodes and the number of goto's to
+//	each is counted so that a label left without any is dropped when the procedure
+//	ends.
+
+#ifndef _HLLEMITTER_
+#define _HLLEMITTER_
+
+#include <string.h>
+#include "StringFunctions.h"
+
+#define EMIT_INIT_SIZE 65536		// the initial size of the buffer
+#define EMIT_FLUSH_SIZE 65536		// the amount of code collected before it is written
+#define MAX_INDENT_RUN 64			// the number of tab stops held in the indentation table
+#define EMIT_MAX_IOV 1024			// the most pieces written by each call of writev
+
+// a label to be put in place when the code is written out
+struct HLLLabel {
+	int offset;					// where the label goes in the code
+	int num;						// the number of the label
+	int seq;						// the order in which it was added
+	int text;					// where Flush formed the text of the label in the buffer
+	int textLen;				// the length of the text
+};
+
+// text added by reference that goes in the code at offset
+struct HLLSlice {
+	int offset;					// where the text goes in the code
+	char const* str;			// the text
+	int len;						// the length of the text
+};
+
+// a goto that has been removed from the code
+struct HLLCut {
+	int start;					// the offset of the goto
+	int end;						// the offset of the code after it
+};
+
+class HLLEmitter {
+public:
+	// constructor allocates a buffer of the given size. If remGotos is true then the
+	// goto's that aren't needed are removed.
+	HLLEmitter(bool remGotos = false, int s = EMIT_INIT_SIZE);
+
+	~HLLEmitter();
+
+	// add indLevel tab stops
+	void Indent(int indLevel);
+
+	// add a string, a string of known length or a single character
+	void Add(char const* str);
+	void Add(char const* str, int len);
+	void Add(char c);
+
+	// add the decimal digits of a non negative integer
+	void AddInt(int n);
+
+	// add a string as a JSON string (see jsonescape in StringFunctions.h)
+	void AddJSONString(char const* str);
+
+	// Pre: str stays unchanged until the code has been written out
+	// Post: the len characters of str go next in the code without being copied
+	void AddRef(char const* str, int len);
+
+	// return the offset at which the next character will be added
+	int Offset() const;
+
+	// Pre: no code has been written out since offset was returned by Offset()
+	// Post: the label "L<num>:" will be written out on its own line at offset
+	void AddLabelAt(int offset, int num);
+
+	// add the label "L<num>:" on its own line
+	void AddLabel(int num);
+
+	// add the statement "goto L<num>;" at the given indentation level
+	void AddGoto(int indLevel, int num);
+
+	// add the closing bracket of a conditional. Control falls through it to the code
+	// that follows.
+	void CloseCond(int indLevel);
+
+	// start the code of a procedure whose labels are numbered from 0 to numLabels - 1
+	void StartProc(int numLabels);
+
+	// end the code of the current procedure. Its labels without any goto are dropped.
+	void EndProc();
+
+	// return the number of goto's removed
+	int NumGotosRemoved() const;
+
+	// return the number of bytes waiting to be written
+	int Size() const;
+
+	// Pre: the code added so far ends at the end of a procedure
+	// Post: the code has been written out to the file fd along with its labels and
+	//		  slices and the buffer is empty. Returns false if the write failed.
+	bool Flush(int fd);
+
+private:
+	// make room for at least len more bytes
+	void Grow(int len);
+
+	// add a piece to be written out to fd by Flush, writing out the pieces so far if
+	// there is no room for it
+	void AddPiece(int fd, char const* str, int len);
+
+	// write out the pieces to fd
+	void WritePieces(int fd);
+
+	char* buf;					// the code
+	int sz;						// the number of bytes of code in buf
+	int avail;					// the size of buf
+	HLLLabel* labels;			// the labels to be put in place by Flush
+	int numLabels;				// the number of labels in labels
+	int labelsAvail;			// the size of labels
+	HLLSlice* slices;			// the text added by reference, in order
+	int numSlices;				// the number of slices in slices
+	int slicesAvail;			// the size of slices
+	int sliceBytes;			// the number of bytes of text in slices
+	struct iovec* pieces;	// the pieces of the code being written out by Flush
+	int numPieces;				// the number of pieces in pieces
+	bool writeFailed;			// has a write by Flush failed?
+
+	// goto removal
+	bool remGotos;				// remove the goto's that aren't needed?
+	int* uses;					// the number of goto's to each label of the procedure
+	int usesAvail;				// the size of uses
+	int procLabels;			// the index in labels of the first label of the procedure
+	int lastGoto;				// the label of the last goto added (-1 if none)
+	int gotoStart;				// the offset of the last goto added
+	int gotoStmtEnd;			// the offset of the code after it
+	int gotoEnd;				// the offset of the code after it and the closing brackets
+									// that follow it
+	HLLCut* cuts;				// the goto's that have been removed, in order
+	int numCuts;				// the number of goto's in cuts
+	int cutsAvail;				// the size of cuts
+	int numRemoved;			// the number of goto's removed altogether
+};
+
+inline void HLLEmitter::Add(char const* str, int len)
+{
+	if (sz + len > avail)
+		Grow(len);
+	memcpy(buf + sz, str, len);
+	sz += len;
+}
+
+inline void HLLEmitter::Add(char const* str) { Add(str, strlen(str)); }
+
+inline void HLLEmitter::Add(char c)
+{
+	if (sz == avail)
+		Grow(1);
+	buf[sz++] = c;
+}
+
+inline void HLLEmitter::AddJSONString(char const* str)
+{
+	int len = JSON_STR_MAX(strlen(str));
+	if (sz + len > avail)
+		Grow(len);
+	sz += jsonescape(str, buf + sz);
+}
+
+inline int HLLEmitter::Offset() const { return sz; }
+inline int HLLEmitter::Size() const { return sz + sliceBytes; }
+inline int HLLEmitter::NumGotosRemoved() const { return numRemoved; }
+
+#endif
@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 1997, Doug Simon
+ *
+ * See the file "LICENSE.TERMS" for information on usage and
+ * redistribution of this file, and for a DISCLAIMER OF ALL
+ * WARRANTIES.
+ *
+ */
+
+//File: HLLTree.cc
+//Author: Doug Simon
+//Purpose: provides the implementation of the HLLTree class
+
+#include <string.h>
+#include "HLLTree.h"
+
+HLLTree::HLLTree() : chunks(NULL), cur(NULL)
+{
+	root.first = root.last = NULL;
+}
+
+HLLTree::~HLLTree()
+{
+	while (chunks)
+	{
+		TreeChunk* next = chunks->next;
+		delete[] chunks->mem;
+		delete chunks;
+		chunks = next;
+	}
+}
+
+void* HLLTree::Alloc(int size)
+{
+	// keep each allocation aligned for a pointer
+	size = (size + sizeof(void*) - 1) & ~(sizeof(void*) - 1);
+
+	if (!cur || cur->used + size > cur->size)
+	{
+		// move on to the next chunk if it is big enough. Otherwise put a new one in
+		// front of it.
+		TreeChunk* next = (cur ? cur->next : chunks);
+		if (!next || next->size < size)
+		{
+			TreeChunk* chunk = new TreeChunk;
+			chunk->size = (size > TREE_CHUNK_SIZE ? size : TREE_CHUNK_SIZE);
+			chunk->mem = new char[chunk->size];
+			chunk->next = next;
+			if (cur)
+				cur->next = chunk;
+			else
+				chunks = chunk;
+			next = chunk;
+		}
+		cur = next;
+		cur->used = 0;
+	}
+
+	void* p = cur->mem + cur->used;
+	cur->used += size;
+	return p;
+}
+
+HLLStmt* HLLTree::Add(HLLList* list, stmtType type)
+{
+	HLLStmt* stmt = (HLLStmt*)Alloc(sizeof(HLLStmt));
+	memset(stmt, 0, sizeof(HLLStmt));
+	stmt->type = type;
+	stmt->skip = -1;
+
+	if (list->last)
+		list->last->next = stmt;
+	else
+		list->first = stmt;
+	list->last = stmt;
+	return stmt;
+}
+
+void HLLTree::AddParts(HLLStmt* stmt, int numParts)
+{
+	stmt->parts = (HLLList*)Alloc(numParts * sizeof(HLLList));
+	memset(stmt->parts, 0, numParts * sizeof(HLLList));
+	stmt->numParts = numParts;
+}
+
+void HLLTree::Clear()
+{
+	root.first = root.last = NULL;
+	cur = NULL;
+}
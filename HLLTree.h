@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 1997, Doug Simon
+ *
+ * See the file "LICENSE.TERMS" for information on usage and
+ * redistribution of this file, and for a DISCLAIMER OF ALL
+ * WARRANTIES.
+ *
+ */
+
+//File: HLLTree.h
+//Author: Doug Simon
+//Purpose: provides the tree of structured statements that the code of a procedure is
+//	generated into. The tree is built once by WriteCode and is then walked by each of
+//	the writers (see HLLWriter.h) that put it into the output formats. The statements
+//	are allocated from large chunks that are kept for the next procedure once the tree
+//	is cleared.
+
+#ifndef _HLLTREE_
+#define _HLLTREE_
+
+#include "Instruction.h"
+
+#define TREE_CHUNK_SIZE 65536		// the usual size of each chunk the statements are
+											// allocated from
+
+// the kinds of statement
+enum stmtType {
+	BlockStmt,			// the instructions of a basic block (leaf)
+	IfStmt,				// if (cond) then [else]
+	WhileStmt,			// while (cond) body
+	DoWhileStmt,		// do body while (cond)
+	ForStmt,				// for (;;) body
+	SwitchStmt,			// switch with one arm per out edge of the header
+	BreakStmt,			// break (leaf)
+	ContinueStmt,		// continue (leaf)
+	GotoStmt,			// goto a label (leaf)
+	ReturnStmt			// return after the delayed instruction of the return block (leaf)
+};
+
+struct HLLStmt;
+
+// a list of statements
+struct HLLList {
+	HLLStmt* first;
+	HLLStmt* last;
+};
+
+// a statement. A compound statement (if, loop or switch) holds its statements in
+// numParts lists: the then and else clauses of an if, the body of a loop or the
+// arms of a switch.
+struct HLLStmt {
+	stmtType type : 8;
+	bool label;							// Block: the label of the block goes before it
+	bool negate;						// If, While: the condition is negated
+	int num;								// Block: the number of the node. Goto: the number of
+											// the label
+	HLLStmt* next;						// the next statement in the same list
+	char const* cond;					// If, While, DoWhile: the branch opcode tested
+	InsPtrArr const* instructs;	// Block: the instructions of the node
+	int skip;							// Block: the index of the instruction left out (-1 if
+											// none)
+	Instruction const* delayed;	// Return: the delayed instruction (NULL if none)
+	HLLList* parts;					// the lists of a compound statement
+	int numParts;						// the number of lists in parts
+
+	// is this a compound statement?
+	bool IsCompound() const { return numParts != 0; }
+};
+
+// a chunk of memory that statements are allocated from
+struct TreeChunk {
+	TreeChunk* next;					// the next chunk
+	int size;							// the number of bytes in mem
+	int used;							// the number of bytes used
+	char* mem;
+};
+
+class HLLTree {
+public:
+	HLLTree();
+	~HLLTree();
+
+	// return the list of the statements of the procedure
+	HLLList* Root() { return &root; }
+
+	// Post: a new statement of the given type with all its other fields clear has
+	//		  been added to the end of list
+	HLLStmt* Add(HLLList* list, stmtType type);
+
+	// Post: stmt is a compound statement with numParts empty lists
+	void AddParts(HLLStmt* stmt, int numParts);
+
+	// Post: the tree is empty. The chunks are kept for the next tree.
+	void Clear();
+
+private:
+	// allocate size bytes aligned for a pointer
+	void* Alloc(int size);
+
+	HLLList root;						// the statements of the procedure
+	TreeChunk* chunks;				// the chunks allocated so far
+	TreeChunk* cur;					// the chunk being allocated from
+};
+
+#endif
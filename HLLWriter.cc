@@ -0,0 +1,557 @@
+/*
+ * Copyright (C) 1997, Doug Simon
+ *
+ * See the file "LICENSE.TERMS" for information on usage and
+ * redistribution of this file, and for a DISCLAIMER OF ALL
+ * WARRANTIES.
+ *
+ */
+
+//File: HLLWriter.cc
+//Author: Doug Simon
+//Purpose: provides the implementation of the writers of the statement tree
+
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <iostream.h>
+#include "HLLWriter.h"
+#include "StringFunctions.h"
+#include "Options.h"
+
+extern Options options;
+
+// the initial number of frames in the stack of a walk
+#define WALK_STACK_INIT 64
+
+// a compound statement whose lists are being walked
+struct WalkFrame {
+	HLLStmt const* stmt;				// the statement
+	int part;							// the list being walked
+	HLLStmt const* next;				// the statement after it
+};
+
+//*********************************************************************
+// The walk shared by all the formats
+//*********************************************************************
+HLLWriter::HLLWriter(char const* fname, char const* ext, bool remGotos) :
+	code(remGotos), name(concatstr(fname, ext))
+{
+	fd = open(name, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+
+	//make sure file was successfully opened
+	if (fd < 0)
+	{
+		cerr << "Error: could not open output file." << endl;
+		exit(1);
+	}
+}
+
+HLLWriter::~HLLWriter()
+{
+	delete[] name;
+}
+
+void HLLWriter::Flush()
+{
+	if (!code.Flush(fd))
+	{
+		cerr << "Error: could not write to " << name << "." << endl;
+		exit(1);
+	}
+}
+
+void HLLWriter::WriteProc(char const* name, int numLabels, HLLList const* body)
+// The tree is walked with an explicit stack so that the depth of the structure isn't
+// limited by the size of the native stack.
+{
+	WalkFrame* stack = new WalkFrame[WALK_STACK_INIT];
+	int sz = 0;
+	int avail = WALK_STACK_INIT;
+	HLLStmt const* stmt = body->first;
+
+	StartProc(name, numLabels);
+	for (;;)
+	{
+		// walk the rest of the current list
+		while (stmt)
+			if (!stmt->IsCompound())
+			{
+				Leaf(stmt, sz);
+				stmt = stmt->next;
+			}
+			else
+			{
+				if (sz == avail)
+				{
+					WalkFrame* newStack = new WalkFrame[avail * 2];
+					memcpy(newStack, stack, sz * sizeof(WalkFrame));
+					delete[] stack;
+					stack = newStack;
+					avail *= 2;
+				}
+				Open(stmt, sz);
+				OpenPart(stmt, 0, sz);
+				stack[sz].stmt = stmt;
+				stack[sz].part = 0;
+				stack[sz].next = stmt->next;
+				sz++;
+				stmt = stmt->parts[0].first;
+			}
+
+		if (sz == 0)
+			break;
+
+		// the current list has ended. Move on to the next list of its statement or to
+		// the statement after it.
+		WalkFrame &f = stack[sz - 1];
+		ClosePart(f.stmt, f.part, sz - 1);
+		if (++f.part < f.stmt->numParts)
+		{
+			OpenPart(f.stmt, f.part, sz - 1);
+			stmt = f.stmt->parts[f.part].first;
+		}
+		else
+		{
+			Close(f.stmt, sz - 1);
+			stmt = f.next;
+			sz--;
+		}
+	}
+	EndProc();
+
+	delete[] stack;
+
+	// Send the output to the file once enough has been collected. The labels of a
+	// procedure are all known once its code has been written.
+	if (code.Size() >= EMIT_FLUSH_SIZE)
+		Flush();
+}
+
+void HLLWriter::Finish()
+{
+	End();
+	Flush();
+	close(fd);
+}
+
+//*********************************************************************
+// The C like code
+//*********************************************************************
+
+// the code of a procedure starts one tab stop in
+#define CIND(depth) ((depth) + 1)
+
+void CWriter::StartProc(char const* name, int numLabels)
+{
+	code.Add('\n');
+	code.Add(name);
+	code.Add("()\n{\n");
+	code.StartProc(numLabels);
+}
+
+void CWriter::EndProc()
+{
+	code.EndProc();
+	code.Add("}\n");
+}
+
+void CWriter::Leaf(HLLStmt const* stmt, int depth)
+{
+	int indLevel = CIND(depth);
+
+	switch (stmt->type) {
+	case BlockStmt:
+		if (stmt->label)
+			code.AddLabel(stmt->num);
+		if (options.blocksOnly)
+		{
+			code.Indent(indLevel);
+			code.Add("BB");
+			code.AddInt(stmt->num);
+			code.Add(";\n");
+		}
+		else
+			for (int i = 0; i < stmt->instructs->Size(); i++)
+				if (i != stmt->skip)
+				{
+					Instruction const* ins = (*stmt->instructs)[i];
+					code.Indent(indLevel);
+					code.AddRef(ins->GetString(), ins->GetLength());
+					code.Add('\n');
+				}
+		break;
+
+	case BreakStmt:
+		code.Indent(indLevel);
+		code.Add("break;\n");
+		break;
+
+	case ContinueStmt:
+		code.Indent(indLevel);
+		code.Add("continue;\n");
+		break;
+
+	case GotoStmt:
+		code.AddGoto(indLevel, stmt->num);
+		break;
+
+	case ReturnStmt:
+		if (stmt->delayed)
+		{
+			code.Indent(indLevel);
+			code.AddRef(stmt->delayed->GetString(), stmt->delayed->GetLength());
+			code.Add('\n');
+		}
+		code.Indent(indLevel);
+		code.Add("return;\n");
+		break;
+
+	default:
+		break;
+	}
+}
+
+void CWriter::Open(HLLStmt const* stmt, int depth)
+{
+	code.Indent(CIND(depth));
+
+	switch (stmt->type) {
+	case IfStmt:
+		code.Add(stmt->negate ? "if (!" : "if (");
+		code.Add(stmt->cond);
+		code.Add(") {\n");
+		break;
+
+	case WhileStmt:
+		code.Add(stmt->negate ? "while (!" : "while (");
+		code.Add(stmt->cond);
+		code.Add(")\n");
+		code.Indent(CIND(depth));
+		code.Add("{\n");
+		break;
+
+	case DoWhileStmt:
+		code.Add("do {\n");
+		break;
+
+	case ForStmt:
+		code.Add("for (;;) {\n");
+		break;
+
+	case SwitchStmt:
+		code.Add("switch (Reg0) {\n");
+		break;
+
+	default:
+		break;
+	}
+}
+
+void CWriter::OpenPart(HLLStmt const* stmt, int part, int depth)
+{
+	if (stmt->type == IfStmt && part == 1)
+	{
+		// generate the 'else' keyword and matching brackets
+		code.Indent(CIND(depth));
+		code.Add("} else\n");
+		code.Indent(CIND(depth));
+		code.Add("{\n");
+	}
+	else if (stmt->type == SwitchStmt)
+	{
+		// emit a case label
+		code.Indent(CIND(depth));
+		code.Add("case cond_");
+		code.AddInt(part);
+		code.Add(":\n");
+	}
+}
+
+void CWriter::ClosePart(HLLStmt const* stmt, int, int depth)
+{
+	if (stmt->type == SwitchStmt)
+	{
+		code.Indent(CIND(depth + 1));
+		code.Add("break;\n");
+	}
+}
+
+void CWriter::Close(HLLStmt const* stmt, int depth)
+{
+	switch (stmt->type) {
+	case IfStmt:
+	case SwitchStmt:
+		code.CloseCond(CIND(depth));
+		break;
+
+	case DoWhileStmt:
+		code.Indent(CIND(depth));
+		code.Add("} while (");
+		code.Add(stmt->cond);
+		code.Add(");\n");
+		break;
+
+	default:
+		code.Indent(CIND(depth));
+		code.Add("}\n");
+		break;
+	}
+}
+
+//*********************************************************************
+// Compact JSON
+//*********************************************************************
+void JSONWriter::StartStmt(char const* type)
+{
+	if (needComma)
+		code.Add(',');
+	code.Add("{\"stmt\":\"");
+	code.Add(type);
+	code.Add('"');
+}
+
+void JSONWriter::StartProc(char const* name, int)
+{
+	code.Add(numProcs++ ? ",\n{\"proc\":" : "[\n{\"proc\":");
+	code.AddJSONString(name);
+	code.Add(",\"body\":[");
+	needComma = false;
+}
+
+void JSONWriter::EndProc()
+{
+	code.Add("]}");
+}
+
+void JSONWriter::End()
+{
+	code.Add(numProcs ? "\n]\n" : "[]\n");
+}
+
+void JSONWriter::Leaf(HLLStmt const* stmt, int)
+{
+	switch (stmt->type) {
+	case BlockStmt:
+		StartStmt("block");
+		code.Add(",\"node\":");
+		code.AddInt(stmt->num);
+		if (stmt->label)
+			code.Add(",\"label\":true");
+		if (!options.blocksOnly)
+		{
+			code.Add(",\"ins\":[");
+			bool first = true;
+			for (int i = 0; i < stmt->instructs->Size(); i++)
+				if (i != stmt->skip)
+				{
+					if (!first)
+						code.Add(',');
+					code.AddJSONString((*stmt->instructs)[i]->GetString());
+					first = false;
+				}
+			code.Add(']');
+		}
+		break;
+
+	case BreakStmt:
+		StartStmt("break");
+		break;
+
+	case ContinueStmt:
+		StartStmt("continue");
+		break;
+
+	case GotoStmt:
+		StartStmt("goto");
+		code.Add(",\"label\":");
+		code.AddInt(stmt->num);
+		break;
+
+	case ReturnStmt:
+		StartStmt("return");
+		if (stmt->delayed)
+		{
+			code.Add(",\"ins\":");
+			code.AddJSONString(stmt->delayed->GetString());
+		}
+		break;
+
+	default:
+		break;
+	}
+	code.Add('}');
+	needComma = true;
+}
+
+void JSONWriter::Open(HLLStmt const* stmt, int)
+{
+	switch (stmt->type) {
+	case IfStmt:
+		StartStmt("if");
+		break;
+	case WhileStmt:
+		StartStmt("while");
+		break;
+	case DoWhileStmt:
+		StartStmt("dowhile");
+		break;
+	case ForStmt:
+		StartStmt("for");
+		break;
+	case SwitchStmt:
+		StartStmt("switch");
+		code.Add(",\"cases\":[");
+		break;
+	default:
+		break;
+	}
+
+	if (stmt->cond)
+	{
+		code.Add(",\"cond\":");
+		code.AddJSONString(stmt->cond);
+		if (stmt->negate)
+			code.Add(",\"neg\":true");
+	}
+}
+
+void JSONWriter::OpenPart(HLLStmt const* stmt, int part, int)
+{
+	if (stmt->type == SwitchStmt)
+		code.Add(part ? ",[" : "[");
+	else if (stmt->type == IfStmt)
+		code.Add(part == 1 ? ",\"else\":[" : ",\"then\":[");
+	else
+		code.Add(",\"body\":[");
+	needComma = false;
+}
+
+void JSONWriter::ClosePart(HLLStmt const*, int, int)
+{
+	code.Add(']');
+}
+
+void JSONWriter::Close(HLLStmt const* stmt, int)
+{
+	code.Add(stmt->type == SwitchStmt ? "]}" : "}");
+	needComma = true;
+}
+
+//*********************************************************************
+// The binary form
+//*********************************************************************
+BinWriter::BinWriter(char const* fname) : HLLWriter(fname, ".hlb")
+{
+	code.Add("HLB", 3);
+	code.Add((char)BIN_FORMAT_VERSION);
+}
+
+void BinWriter::AddNum(unsigned int n)
+{
+	while (n >= 0x80)
+	{
+		code.Add((char)((n & 0x7f) | 0x80));
+		n >>= 7;
+	}
+	code.Add((char)n);
+}
+
+void BinWriter::AddString(char const* str)
+{
+	int len = strlen(str);
+	AddNum(len);
+	code.Add(str, len);
+}
+
+void BinWriter::AddString(Instruction const* ins)
+{
+	AddNum(ins->GetLength());
+	code.AddRef(ins->GetString(), ins->GetLength());
+}
+
+void BinWriter::StartProc(char const* name, int numLabels)
+{
+	AddString(name);
+	AddNum(numLabels);
+}
+
+void BinWriter::EndProc()
+{
+	// the end of the list of the procedure
+	code.Add('\0');
+}
+
+void BinWriter::Leaf(HLLStmt const* stmt, int)
+{
+	code.Add((char)(stmt->type + 1));
+
+	switch (stmt->type) {
+	case BlockStmt:
+		AddNum(stmt->num);
+		code.Add((char)(stmt->label ? 1 : 0));
+		if (options.blocksOnly)
+			AddNum(0);
+		else
+		{
+			InsPtrArr const &instructs = *stmt->instructs;
+			AddNum(instructs.Size() - (stmt->skip == -1 ? 0 : 1));
+			for (int i = 0; i < instructs.Size(); i++)
+				if (i != stmt->skip)
+					AddString(instructs[i]);
+		}
+		break;
+
+	case GotoStmt:
+		AddNum(stmt->num);
+		break;
+
+	case ReturnStmt:
+		if (stmt->delayed)
+		{
+			AddNum(1);
+			AddString(stmt->delayed);
+		}
+		else
+			AddNum(0);
+		break;
+
+	default:
+		break;
+	}
+}
+
+void BinWriter::Open(HLLStmt const* stmt, int)
+{
+	code.Add((char)(stmt->type + 1));
+
+	switch (stmt->type) {
+	case IfStmt:
+		code.Add((char)((stmt->negate ? 1 : 0) | (stmt->numParts == 2 ? 2 : 0)));
+		AddString(stmt->cond);
+		break;
+
+	case WhileStmt:
+		code.Add((char)(stmt->negate ? 1 : 0));
+		AddString(stmt->cond);
+		break;
+
+	case DoWhileStmt:
+		AddString(stmt->cond);
+		break;
+
+	case SwitchStmt:
+		AddNum(stmt->numParts);
+		break;
+
+	default:
+		break;
+	}
+}
+
+void BinWriter::ClosePart(HLLStmt const*, int, int)
+{
+	// the end of the list
+	code.Add('\0');
+}
@@ -0,0 +1,160 @@
+/*
+ * Copyright (C) 1997, Doug Simon
+ *
+ * See the file "LICENSE.TERMS" for information on usage and
+ * redistribution of this file, and for a DISCLAIMER OF ALL
+ * WARRANTIES.
+ *
+ */
+
+//File: HLLWriter.h
+//Author: Doug Simon
+//Purpose: provides the writers that put the statement tree of each procedure into an
+//	output format. The tree is walked without recursion by HLLWriter, which hands each
+//	statement to the writer of the format:
+//
+//	CWriter		the C like code written to <file>.hll. It can remove the goto's that
+//					aren't needed (see HLLEmitter.h).
+//	JSONWriter	compact JSON written to <file>.json. The file holds an array with one
+//					object per procedure on each line:
+//						{"proc":name,"body":[statement,...]}
+//					where a statement is one of
+//						{"stmt":"block","node":n[,"label":true][,"ins":[string,...]]}
+//						{"stmt":"if","cond":op[,"neg":true],"then":[...][,"else":[...]]}
+//						{"stmt":"while","cond":op[,"neg":true],"body":[...]}
+//						{"stmt":"dowhile","cond":op,"body":[...]}
+//						{"stmt":"for","body":[...]}
+//						{"stmt":"switch","cases":[[...],...]}
+//						{"stmt":"goto","label":n}
+//						{"stmt":"return"[,"ins":string]}
+//						{"stmt":"break"} and {"stmt":"continue"}
+//	BinWriter	a binary form written to <file>.hlb. The file starts with the bytes
+//					"HLB" and the format version, followed by each procedure: its name,
+//					its number of labels and its list of statements. A list is its
+//					statements followed by a 0 byte. A statement is its type plus one
+//					followed by
+//						block:		node, flags (1 = label), #ins, ins ...
+//						if:			flags (1 = negated, 2 = has else), cond, then [else]
+//						while:		flags (1 = negated), cond, body
+//						dowhile:		cond, body
+//						for:			body
+//						switch:		#arms, arm ...
+//						goto:			label
+//						return:		#ins (0 or 1), [ins]
+//						break, continue: nothing
+//					where a number is unsigned LEB128 (7 bits per byte, low bits first)
+//					and a string is its length followed by its characters.
+//
+//	The instructions of the blocks are left out of each format when only blocks are
+//	to be generated (-b).
+
+#ifndef _HLLWRITER_
+#define _HLLWRITER_
+
+#include "HLLTree.h"
+#include "HLLEmitter.h"
+
+#define BIN_FORMAT_VERSION 1		// the version of the binary form
+
+class HLLWriter {
+public:
+	// Post: the file <fname><ext> has been opened for the output
+	HLLWriter(char const* fname, char const* ext, bool remGotos = false);
+
+	virtual ~HLLWriter();
+
+	// write the statements of a procedure whose labels are numbered from 0 to
+	// numLabels - 1
+	void WriteProc(char const* name, int numLabels, HLLList const* body);
+
+	// write out anything still held and close the file
+	void Finish();
+
+	// return the number of goto's removed
+	int NumGotosRemoved() const { return code.NumGotosRemoved(); }
+
+protected:
+	// The steps of the walk. The statements at the top of a procedure are at depth 0
+	// and those in the lists of a compound statement at depth d are at depth d + 1.
+	virtual void StartProc(char const* name, int numLabels) = 0;
+	virtual void EndProc() = 0;
+
+	// a statement that isn't compound
+	virtual void Leaf(HLLStmt const* stmt, int depth) = 0;
+
+	// a compound statement is opened, then each of its lists is opened, walked and
+	// closed in turn and then the statement is closed
+	virtual void Open(HLLStmt const* stmt, int depth) = 0;
+	virtual void OpenPart(HLLStmt const* stmt, int part, int depth) = 0;
+	virtual void ClosePart(HLLStmt const* stmt, int part, int depth) = 0;
+	virtual void Close(HLLStmt const* stmt, int depth) = 0;
+
+	// called by Finish before the code is written out
+	virtual void End() {}
+
+	// write out the output collected so far
+	void Flush();
+
+	HLLEmitter code;					// the output waiting to be written
+	char* name;							// the name of the output file
+	int fd;								// the output file
+};
+
+class CWriter : public HLLWriter {
+public:
+	CWriter(char const* fname, bool remGotos) : HLLWriter(fname, ".hll", remGotos) {}
+
+protected:
+	void StartProc(char const* name, int numLabels);
+	void EndProc();
+	void Leaf(HLLStmt const* stmt, int depth);
+	void Open(HLLStmt const* stmt, int depth);
+	void OpenPart(HLLStmt const* stmt, int part, int depth);
+	void ClosePart(HLLStmt const* stmt, int part, int depth);
+	void Close(HLLStmt const* stmt, int depth);
+};
+
+class JSONWriter : public HLLWriter {
+public:
+	JSONWriter(char const* fname) : HLLWriter(fname, ".json"), numProcs(0), needComma(false) {}
+
+protected:
+	void StartProc(char const* name, int numLabels);
+	void EndProc();
+	void Leaf(HLLStmt const* stmt, int depth);
+	void Open(HLLStmt const* stmt, int depth);
+	void OpenPart(HLLStmt const* stmt, int part, int depth);
+	void ClosePart(HLLStmt const* stmt, int part, int depth);
+	void Close(HLLStmt const* stmt, int depth);
+	void End();
+
+private:
+	// add the start of the object for a statement
+	void StartStmt(char const* type);
+
+	int numProcs;						// the number of procedures written
+	bool needComma;					// does a comma go before the next statement?
+};
+
+class BinWriter : public HLLWriter {
+public:
+	BinWriter(char const* fname);
+
+protected:
+	void StartProc(char const* name, int numLabels);
+	void EndProc();
+	void Leaf(HLLStmt const* stmt, int depth);
+	void Open(HLLStmt const* stmt, int depth);
+	void OpenPart(HLLStmt const*, int, int) {}
+	void ClosePart(HLLStmt const* stmt, int part, int depth);
+	void Close(HLLStmt const*, int) {}
+
+private:
+	// add a number and a string. The characters of an instruction are added by
+	// reference.
+	void AddNum(unsigned int n);
+	void AddString(char const* str);
+	void AddString(Instruction const* ins);
+};
+
+#endif
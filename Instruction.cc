@@ -33,7 +33,8 @@ char *getOpcode(char *line)
 
 void Instruction::copy (Instruction const &other)
 {
-	srep = mystrdup(other.srep);
+	srep = other.srep;
+	srepLen = other.srepLen;
 	opcode = other.opcode;
 	labels = other.labels;
 	procLabel = mystrdup(other.procLabel);
@@ -46,14 +47,13 @@ void Instruction::copy (Instruction const &other)
 
 void Instruction::destroy()
 {
-	if (srep) delete srep;
 	if (procLabel) delete procLabel;
 	if (branchDestLabel) delete branchDestLabel;
 }
 
 //default constructor
 Instruction::Instruction()
-	: srep(NULL), procLabel(NULL), bTarget(NULL), branchDestLabel(NULL)
+	: srep(NULL), srepLen(0), procLabel(NULL), bTarget(NULL), branchDestLabel(NULL)
 {}
 
 //copy constructor
@@ -93,12 +93,13 @@ void Instruction::InitString(char const *line)
         int i,j;
 	char *opString;
 
-	//build the srep
+	//the srep is the line without its leading white space
         for (i = 0; !isalpha(line[i]); i++);
-	srep = substr(line,i,strlen(line) - i);
+	srep = line + i;
+	srepLen = strlen(srep);
 
 	//extract the opcode out of the srep
-	opString = getOpcode(srep);
+	opString = getOpcode((char*)srep);
 	opcode = String2Type(opString);
 
 	//build the dest label(s) if this is a jmp or branch instruction
@@ -126,7 +127,8 @@ void Instruction::InitString(char const *line)
 	}
 }
 
-char const* Instruction::GetString() const { return (char const *)srep; }
+char const* Instruction::GetString() const { return srep; }
+int Instruction::GetLength() const { return srepLen; }
 
 iType Instruction::GetType() const { return opcode; }
 
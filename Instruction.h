@@ -47,11 +47,16 @@ public:
 
 	//builds most of the data stored in an instruction object
 	//from the given string representation of the instruction.
+	//NOTE: the instruction keeps pointing into line rather than copying it so line
+	//must not change or go away while the instruction is in use
 	void InitString(char const*line);	
 
 	//return the string representation of an instruction
 	char const* GetString() const;	
 
+	//return the length of the string representation
+	int GetLength() const;
+
 	//returns the opcode
 	iType GetType() const;		
 
@@ -93,7 +98,9 @@ public:
 	const InsPtrArr &GetJmpDests() const;
 
 private:
-	char *srep;			//string representation of the instruction
+	char const* srep;		//string representation of the instruction (points into
+								//the line it was built from)
+	int srepLen;			//length of srep
 	iType opcode;			//opcode of instruction
 	StrArr labels;			//labels at this instruction
 	char* procLabel;
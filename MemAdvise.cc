@@ -13,23 +13,202 @@
 
 #include "MemAdvise.h"
 #include <malloc.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+
+// The header in front of each block holds its size. It is as large as the most
+// strictly aligned type so that the block after it is aligned as malloc aligns it.
+union MemHeader {
+	size_t size;
+	long double ld;
+	double d;
+	long l;
+	void* p;
+};
+
+// the counts of one thread. Only the thread itself changes them but the totals read
+// them while it runs.
+struct MemCounters {
+	long allocated;							// bytes allocated
+	long freed;									// bytes freed
+	long phaseBytes[NUM_PHASES];		// bytes allocated in each phase
+	long phaseAllocs[NUM_PHASES];	// allocations made in each phase
+	MemCounters* prev;						// the other running threads
+	MemCounters* next;
+};
+
+static __thread MemCounters* myCounters;		// the counts of the calling thread
+static MemCounters* running;						// the counts of the running threads
+static MemCounters retired;						// the counts of the threads that have
+															// ended
+static pthread_mutex_t countersLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t countersKey;				// retires the counts of a thread as it ends
+static pthread_once_t keyOnce = PTHREAD_ONCE_INIT;
+static toolPhase curPhase = OtherPhase;
+
+// add n to a count of the calling thread
+static inline void Bump(long &count, long n)
+{
+	__atomic_store_n(&count, __atomic_load_n(&count, __ATOMIC_RELAXED) + n, __ATOMIC_RELAXED);
+}
+
+// return a count of another thread
+static inline long Read(long const &count)
+{
+	return __atomic_load_n(&count, __ATOMIC_RELAXED);
+}
+
+// add the counts of a thread that has ended to those of the retired threads
+static void Retire(void* arg)
+{
+	MemCounters* c = (MemCounters*)arg;
+
+	pthread_mutex_lock(&countersLock);
+	retired.allocated += c->allocated;
+	retired.freed += c->freed;
+	for (int i = 0; i < NUM_PHASES; i++)
+	{
+		retired.phaseBytes[i] += c->phaseBytes[i];
+		retired.phaseAllocs[i] += c->phaseAllocs[i];
+	}
+	if (c->prev)
+		c->prev->next = c->next;
+	else
+		running = c->next;
+	if (c->next)
+		c->next->prev = c->prev;
+	pthread_mutex_unlock(&countersLock);
+
+	// anything the thread frees from here on starts new counts
+	myCounters = NULL;
+	free(c);
+}
+
+static void CreateKey()
+{
+	pthread_key_create(&countersKey, Retire);
+}
+
+// return the counts of the calling thread, starting them on its first allocation
+static MemCounters* Counters()
+{
+	if (myCounters)
+		return myCounters;
+
+	// the counts are allocated with calloc as operator new would count them
+	MemCounters* c = (MemCounters*)calloc(1, sizeof(MemCounters));
+	if (c == NULL)
+		abort();
+	pthread_once(&keyOnce, CreateKey);
+	pthread_mutex_lock(&countersLock);
+	c->next = running;
+	if (running)
+		running->prev = c;
+	running = c;
+	pthread_mutex_unlock(&countersLock);
+	pthread_setspecific(countersKey, c);
+	myCounters = c;
+	return c;
+}
+
+void MemAdded(size_t sz)
+{
+	MemCounters* c = Counters();
+	Bump(c->allocated, sz);
+	Bump(c->phaseBytes[curPhase], sz);
+	Bump(c->phaseAllocs[curPhase], 1);
+}
+
+void MemRemoved(size_t sz)
+{
+	Bump(Counters()->freed, sz);
+}
 
 void* operator new(size_t sz)
 {
-	MemStats[0] += sz;
-	MemStats[2] += sz;
-	void* p = malloc(sz + sizeof(int));
-	*((int*) p) = sz;
-	return (void*)((int*)p + 1);
+	MemHeader* h = (MemHeader*)malloc(sizeof(MemHeader) + sz);
+	if (h == NULL)
+		abort();
+	MemAdded(sz);
+	h->size = sz;
+	return (void*)(h + 1);
 }
 
 void operator delete(void* p)
 {
 	// removing this check leads to problems
 	if(p != 0x0)
-	{	
-		MemStats[1] += *((int*)((int*)p - 1));
-		MemStats[2] -= *((int*)((int*)p - 1));
-		free ((int*)p - 1);
+	{
+		MemHeader* h = (MemHeader*)p - 1;
+		MemRemoved(h->size);
+		free(h);
 	}
 }
+
+void SetMemPhase(toolPhase p)
+{
+	curPhase = p;
+}
+
+// add up the counts of all the threads
+static void Totals(MemCounters &total)
+{
+	pthread_mutex_lock(&countersLock);
+	total = retired;
+	for (MemCounters* c = running; c; c = c->next)
+	{
+		total.allocated += Read(c->allocated);
+		total.freed += Read(c->freed);
+		for (int i = 0; i < NUM_PHASES; i++)
+		{
+			total.phaseBytes[i] += Read(c->phaseBytes[i]);
+			total.phaseAllocs[i] += Read(c->phaseAllocs[i]);
+		}
+	}
+	pthread_mutex_unlock(&countersLock);
+}
+
+long MemAllocated()
+{
+	MemCounters total;
+	Totals(total);
+	return total.allocated;
+}
+
+long MemFreed()
+{
+	MemCounters total;
+	Totals(total);
+	return total.freed;
+}
+
+long MemInUse()
+{
+	MemCounters total;
+	Totals(total);
+	return total.allocated - total.freed;
+}
+
+long MemPhaseBytes(toolPhase p)
+{
+	MemCounters total;
+	Totals(total);
+	return total.phaseBytes[p];
+}
+
+long MemPhaseAllocs(toolPhase p)
+{
+	MemCounters total;
+	Totals(total);
+	return total.phaseAllocs[p];
+}
+
+long MemPeakRSS()
+{
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+		return 0;
+	return usage.ru_maxrss;
+}
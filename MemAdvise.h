@@ -9,19 +9,45 @@
 
 // File: MemAdvise.h
 // Author: Doug Simon
-// Purpose: gather memory usage statistics
+// Purpose: gather memory usage statistics. Each thread counts the memory it
+//	allocates and frees in its own counters so that threads can allocate without
+//	sharing anything. The counters of all the threads are added up when the totals
+//	are asked for. The memory allocated is also attributed to the phase of the tool
+//	that is running when it is allocated (toolPhase in Stats.h).
 
 #ifndef _MEMADVISE_
 #define _MEMADVISE_
 
 #include <malloc.h>
+#include "Stats.h"
 
-extern int MemStats[3]; // Total allocated, total deallocated, currently
-						// allocated
-
-// built in operator new. Updates the global memory stats variable
+// built in operator new. Counts the memory for the calling thread.
 void* operator new(size_t sz);
 
-// built in operator delete. Updates the global memory stats variable
+// built in operator delete. Counts the memory for the calling thread.
 void operator delete(void* p);
+
+// count sz bytes allocated or freed by the calling thread for memory that is
+// allocated by other means than the operators above
+void MemAdded(size_t sz);
+void MemRemoved(size_t sz);
+
+// Pre: no thread other than the calling one is running
+// Post: the memory allocated from now on is attributed to phase p
+void SetMemPhase(toolPhase p);
+
+// return the total number of bytes allocated, freed and currently allocated by all
+// the threads
+long MemAllocated();
+long MemFreed();
+long MemInUse();
+
+// return the number of bytes and the number of allocations attributed to a phase
+long MemPhaseBytes(toolPhase p);
+long MemPhaseAllocs(toolPhase p);
+
+// return the largest resident set size of the process so far (in kilobytes, as
+// given by getrusage)
+long MemPeakRSS();
+
 #endif
@@ -12,24 +12,21 @@
 //Purpose: provides the implementation of the CFGNode class's operations
 
 #include "Node.h"
+#include "MemAdvise.h"
 #include <assert.h>
+#include <stdlib.h>
 #include <string.h>
 
 CFGNode::CFGNode(int i, Instruction const* first, int num) :
-	id(i), instructs(num), ord(-1), revOrd(-1), inEdgesVisited(0), 
-	numForwardInEdges(-1), traversed(UNTRAVERSED), next(NULL), hllLabel(false), 
-	labelStr(0), indentLevel(0), immPDom(NULL), loopHead(NULL), caseHead(NULL),
+	ord(-1), revOrd(-1), immPDom(NULL), loopHead(NULL), caseHead(NULL),
 	condFollow(NULL), loopFollow(NULL), latchNode(NULL), sType(Seq), 
-	usType(Structured) 
-#ifdef INTERVALS
-	, interval(NULL)
-#endif
+	usType(Structured), traversed(UNTRAVERSED), id(i), text(new NodeText(num))
 {
 	int delimit;	//index of the delimiting instruction
 
+	InsPtrArr &instructs = text->instructs;
+
 	//initialize the two timestamp tuples
-	loopStamps = new int[2];
-	revLoopStamps = new int[2];
 	for (int i = 0; i < 2; i++)
 		loopStamps[i] = revLoopStamps[i] = -1;
 
@@ -60,11 +57,44 @@ CFGNode::CFGNode(int i, Instruction const* first, int num) :
 	}
 }
 
+CFGNode::CFGNode(int i, CFGNode const& other) :
+	ord(-1), revOrd(-1), immPDom(NULL), loopHead(NULL), caseHead(NULL),
+	condFollow(NULL), loopFollow(NULL), latchNode(NULL), type(other.type), sType(Seq), 
+	usType(Structured), traversed(UNTRAVERSED), id(i), text(new NodeText(other.text->instructs))
+{
+	//initialize the two timestamp tuples
+	for (int i = 0; i < 2; i++)
+		loopStamps[i] = revLoopStamps[i] = -1;
+
+	outEdges.Init(other.outEdges.Size());
+}
+
 //bool CFGNode::operator==(CFGNode const& other) const { return &other == this; }
 //bool CFGNode::operator!=(CFGNode const& other) const { return &other != this; }
 CFGNode::~CFGNode()
 {
-	if (labelStr) delete labelStr;
+	delete text;
+}
+
+void* CFGNode::operator new(size_t sz)
+{
+	void* p = memalign(NODE_ALIGN, sz);
+	if (p == NULL)
+	{
+		cerr << "Error: there is no memory left for a node." << endl;
+		abort();
+	}
+	MemAdded(sz);
+	return p;
+}
+
+void CFGNode::operator delete(void* p, size_t sz)
+{
+	if (p)
+	{
+		MemRemoved(sz);
+		free(p);
+	}
 }
 
 int CFGNode::Ident() const { return id; }
@@ -72,23 +102,10 @@ bbType CFGNode::GetType() const { return type; }
 bool CFGNode::IsJumpToReturn() const 
 { 
 	return (type == uBranch && outEdges[0]->type == ret &&
-			  outEdges[0]->instructs.Size() == 2); 
-}
-
-InsPtrArr const &CFGNode::Instructions() const { return instructs; }
-int CFGNode::InsSpace() const
-{
-	int space = 0;
-	for (int i = 0; i < instructs.Size(); i++)
-		space += strlen(instructs[i]->GetString()) + 1;
-
-	// subtract the space taken up a non-procedure call CTI (if any)
-	if (type == cBranch || type == uBranch || type == nway || type == ret)
-		space -= strlen(instructs[instructs.Size() - 2]->GetString()) + 1;
-
-	return space;
+			  outEdges[0]->text->instructs.Size() == 2); 
 }
 
+InsPtrArr const &CFGNode::Instructions() const { return text->instructs; }
 Instruction const* CFGNode::GetCTI() const 
 {
 	//return NULL if this is a fall through node
@@ -98,11 +115,11 @@ Instruction const* CFGNode::GetCTI() const
 	//else return a pointer to the 2nd last instruction in this block which will
 	//invariably be a CTI
 	else
-		return instructs[instructs.Size() - 2];
+		return text->instructs[text->instructs.Size() - 2];
 }
 
-char const* CFGNode::GetProcLabel() const { return instructs[0]->GetProcLabel(); }
-const StrArr &CFGNode::GetNonProcLabels() const {return instructs[0]->GetNonProcLabels(); }
+char const* CFGNode::GetProcLabel() const { return text->instructs[0]->GetProcLabel(); }
+const StrArr &CFGNode::GetNonProcLabels() const {return text->instructs[0]->GetNonProcLabels(); }
 
 void CFGNode::DfsTag()
 {
@@ -137,7 +154,6 @@ void CFGNode::SetLoopStamps(int &time, NodePtrArr &order)
 	order.Add(this);
 }
 
-#ifndef INTERVALS
 void CFGNode::SetRevLoopStamps(int &time)
 {
 	//timestamp the current node with the current time and set its traversed flag
@@ -155,7 +171,15 @@ void CFGNode::SetRevLoopStamps(int &time)
 	//set the the second loopStamp value
 	revLoopStamps[1] = ++time;
 }
-#endif
+
+void CFGNode::CopyStamps(StampCols &cols) const
+{
+	assert(ord != -1);
+	cols.loopIn[ord] = loopStamps[0];
+	cols.loopOut[ord] = loopStamps[1];
+	cols.revIn[ord] = revLoopStamps[0];
+	cols.revOut[ord] = revLoopStamps[1];
+}
 
 void CFGNode::SetRevOrder(NodePtrArr &order)
 {
@@ -186,7 +210,6 @@ int CFGNode::RevOrder() const
 	return revOrd;
 }
 
-#ifndef INTERVALS
 bool CFGNode::InLoop(CFGNode const* header, CFGNode const* latch) const
 {
 	assert(header->latchNode == latch);
@@ -207,7 +230,6 @@ bool CFGNode::InLoop(CFGNode const* header, CFGNode const* latch) const
 		(header->revLoopStamps[0] < revLoopStamps[0] && revLoopStamps[1] < header->revLoopStamps[1] &&
 		 revLoopStamps[0] < latch->revLoopStamps[0] && latch->revLoopStamps[1] < revLoopStamps[1]));
 }
-#endif
 
 void CFGNode::AddEdgeTo(CFGNode* dest) 
 { 
@@ -218,13 +240,12 @@ void CFGNode::AddEdgeTo(CFGNode* dest)
 		type = fall;
 }
 
-#ifdef INTERVALS
-void CFGNode::AddEdgeFrom(CFGNode* src) 
-{ 
-	if (!inEdges.IsIn(src))
-		inEdges.Add(static_cast<CFGNode*>(src)); 
+void CFGNode::RedirectEdges(CFGNode const* oldDest, CFGNode* newDest)
+{
+	for (int i = 0; i < outEdges.Size(); i++)
+		if (outEdges[i] == oldDest)
+			outEdges[i] = newDest;
 }
-#endif
 
 NodePtrArr const &CFGNode::GetOutEdges() const { return outEdges; }
 NodePtrArr const &CFGNode::GetInEdges() const { return inEdges; }
@@ -238,8 +259,8 @@ bool CFGNode::HasEdgeTo(CFGNode const *dest) const
 
 travType CFGNode::Traversed() const { return traversed; }
 
-void CFGNode::SetNext(CFGNode const* dest) { next = (CFGNode*)dest; }
-CFGNode* CFGNode::Next() const { return next; }
+void CFGNode::SetNext(CFGNode const* dest) { text->next = (CFGNode*)dest; }
+CFGNode* CFGNode::Next() const { return text->next; }
 
 bool CFGNode::IsAncestorOf(CFGNode const* other) const
 {           
@@ -291,16 +312,18 @@ void CFGNode::SetCaseHead(CFGNode const* head, CFGNode const* follow)
 	// tagged so skip straight to its follow
 	if (type == nway && this != head)
 	{
-		if (condFollow->traversed != DFS_CASE && condFollow != follow)
+		if (condFollow != follow && condFollow->traversed != DFS_CASE)
 			condFollow->SetCaseHead(head, follow);
 	}
 	else
 		// traverse each child of this node that:
-		//   i) isn't on a back-edge,
-		//  ii) hasn't already been traversed in a case tagging traversal and,
-		// iii) isn't the follow node.
+		//   i) isn't the follow node,
+		//  ii) isn't on a back-edge and,
+		// iii) hasn't already been traversed in a case tagging traversal.
+		// The follow is tested first so that it is never looked at (it may be in a
+		// region being structured by another thread).
 		for (int i = 0; i < outEdges.Size(); i++)
-			if (!HasBackEdgeTo(outEdges[i]) && outEdges[i]->traversed != DFS_CASE && outEdges[i] != follow)
+			if (outEdges[i] != follow && !HasBackEdgeTo(outEdges[i]) && outEdges[i]->traversed != DFS_CASE)
 				outEdges[i]->SetCaseHead(head, follow);
 }
 		
@@ -373,10 +396,14 @@ CFGNode* CFGNode::GetLoopFollow() const { return loopFollow; }
 void CFGNode::SetCondFollow(CFGNode const* other) { condFollow = (CFGNode*)other; }
 CFGNode* CFGNode::GetCondFollow() const { return condFollow; }
 
-#ifdef INTERVALS
-void CFGNode::SetInterval(CFGNode* enclosingI) { interval = enclosingI; }
-CFGNode* CFGNode::InInterval() const { return interval; }
-#endif
+void CFGNode::ResetStructInfo()
+{
+	revLoopStamps[0] = revLoopStamps[1] = -1;
+	traversed = UNTRAVERSED;
+	immPDom = loopHead = caseHead = condFollow = loopFollow = latchNode = NULL;
+	sType = Seq;
+	usType = Structured;
+}
 
 // Include the operations that generate the HLL code
 #include "NodeCodeGen.cc"
@@ -18,13 +18,21 @@
 
 #include "Instruction.h"
 #include "DynArr.h"
+#include "HLLTree.h"
 
 // We define the indicies for the THEN and ELSE out edges of a two-way conditional
 #define THEN 0
 #define ELSE 1
 
-// We define a type to represent a pair of time stamps
-typedef int* TimeStamps;
+// We define a type to store the time stamp tuples of all the nodes in a procedure as
+// contiguous columns indexed by the order of each node. This is the layout used by
+// the loop membership tests which sweep a whole range of the ordering at once.
+struct StampCols {
+	int* loopIn;			// first loop stamp of each node
+	int* loopOut;			// second loop stamp of each node
+	int* revIn;				// first reverse loop stamp of each node
+	int* revOut;			// second reverse loop stamp of each node
+};
 
 // forward declare the Instruction class so that the following typedefs will compile
 class CFGNode;
@@ -32,6 +40,37 @@ class CFGNode;
 // define a type for an array of node pointers
 typedef DynArr<CFGNode*> NodePtrArr;
 
+// the stack of pending steps used to generate code
+class GenStack;
+
+// a stack of nodes with a constant time membership test
+class CountedNodeSet;
+
+// the alignment of each node. A node starts on a cache line boundary so that the fields
+// read by the structuring phases take up as few lines as possible.
+#define NODE_ALIGN 64
+
+// We define a type for the parts of a node that are only needed to build the graph and
+// to generate code. They are kept apart from the node so that the fields read by the
+// structuring phases are packed together.
+struct NodeText {
+	InsPtrArr instructs;				// member instructions
+	CFGNode* next;						// next node in linked list
+	bool hllLabel;						// emit a label for this node when generating HL code?
+	HLLStmt* labelStmt;				// the statement the label for this node goes before
+	int indentLevel;					// the indentation level of this node in the final code
+	int numForwardInEdges;			// the number of in edges that aren't back edges
+	int inEdgesVisited;				// the number of those whose source has had its code
+											// generated
+
+	NodeText(int num) :
+		instructs(num), next(NULL), hllLabel(false), labelStmt(NULL), indentLevel(0),
+		numForwardInEdges(0), inEdgesVisited(0) {}
+	NodeText(InsPtrArr const& ins) :
+		instructs(ins), next(NULL), hllLabel(false), labelStmt(NULL), indentLevel(0),
+		numForwardInEdges(0), inEdgesVisited(0) {}
+};
+
 // an enumerated type for the class of stucture determined for a node
 enum structType { 
 	Loop,					// Header of a loop only
@@ -82,9 +121,17 @@ public:
 	// constructor sets the identity as well as the member instructions
 	CFGNode(int i, Instruction const* first, int num);	
 
+	// constructor for a duplicate of other made when splitting nodes. The duplicate has
+	// the same member instructions and type as other but no edges.
+	CFGNode(int i, CFGNode const& other);
+
 	// destructor cleans up any strings in the node
 	~CFGNode();
 
+	// allocate and free a node on a cache line boundary, keeping the memory stats
+	void* operator new(size_t sz);
+	void operator delete(void* p, size_t sz);
+
 	// return the unique identifier
 	int Ident() const;			
 
@@ -117,11 +164,13 @@ public:
 	// this traversal.
 	void SetLoopStamps(int &time, NodePtrArr &order);
 
-#ifndef INTERVALS
 	// This sets the reverse loop stamps for each node. The children are traversed in
 	// reverse order.
 	void SetRevLoopStamps(int &time);
-#endif
+
+	// Pre: both time stamp tuples and the ordering of this node have been set
+	// Copy the time stamp tuples of this node into the columns at the index of its order
+	void CopyStamps(StampCols &cols) const;
 
 	// Build the ordering of the nodes in the reverse graph that will be used to
 	// determine the immediate post dominators for each node
@@ -133,20 +182,15 @@ public:
 	// Return the index of this node within the post dominator ordering array
 	int RevOrder() const;
 
-#ifndef INTERVALS
 	// Is this node within the loop induced by (header,latch)?
 	bool InLoop(CFGNode const* header, CFGNode const* latch) const;	
-#endif
 
 	// Add an edge from this node to dest. If this is a cBranch type of node and it already
 	// has an edge to dest then node edge is added and the node type is changed to fall
 	void AddEdgeTo(CFGNode* dest);		
 
-#ifdef INTERVALS
-	// Add an edge from src to this node if it doesn't already exist. NB: only interval
-	// nodes need this routine as the in edges for normal nodes are built in SetLoopStamps
-	void AddEdgeFrom(CFGNode* src);
-#endif
+	// Make every edge from this node to oldDest go to newDest instead
+	void RedirectEdges(CFGNode const* oldDest, CFGNode* newDest);
 
 	// Return the list of nodes to whom this node has an edge
 	NodePtrArr const& GetOutEdges() const;		
@@ -244,73 +288,89 @@ public:
 	// Return the node that follows this conditional
 	CFGNode* GetCondFollow() const;					
 
-#ifdef INTERVALS
-	// Record the interval to which this node belongs
-	void SetInterval(CFGNode* enclosingI);
-
-	// Return the enclosing interval of this node
-	CFGNode* InInterval() const;
-#endif
+	// Undo the structuring of this node so that it can be structured again. The reverse
+	// loop stamps are also cleared as they are only set for the parenthesis structurer.
+	void ResetStructInfo();
 
-	// Emit a goto statement to the given destination as well as making sure that
+	// Add a goto statement to the given destination to list as well as making sure that
 	// this destination gives itself a label
-	void EmitGotoAndLabel(StrArr &HLLCode, int indLevel, CFGNode* dest);
+	void EmitGotoAndLabel(HLLTree &tree, HLLList* list, CFGNode* dest);
 
-	// Write the code for for this node at the appropriate indentation level
-	void WriteCode(StrArr &HLLCode, int indLevel, CFGNode const* latch, NodePtrArr &followSet, NodePtrArr &gotoFollowSet);
+	// Count the in edges of this node that aren't back edges and clear the count of
+	// those whose source has had its code generated. This is done for every node of a
+	// procedure before its code is generated.
+	void InitParentCount();
 
-#ifdef INTERVALS
-protected:
-	// Constructor used by the IntNode derived class
-	CFGNode(int newId, bbType t) { id = newId; type = t; }
-#endif
+	// Add the statements for this node to list. indLevel is the indentation level they
+	// will have in the final code.
+	void WriteCode(HLLTree &tree, HLLList* list, int indLevel, CFGNode const* latch, CountedNodeSet &followSet, CountedNodeSet &gotoFollowSet);
 
 private:
 
-	int id;								// unique identifier 
-	bbType type;						// basic block type
-	InsPtrArr instructs;				// member instructions
-	NodePtrArr outEdges;				// pointers to the nodes on an out edge from this node
-	NodePtrArr inEdges;				// pointers to the nodes on an in edge to this node
+	// analysis information read by the structuring phases. These fields come first
+	// so that they sit together at the start of the node's cache lines.
 	int ord;								// node's position within the ordering structure
 	int revOrd;						// node's position within the ordering structure for the reverse graph
-	int inEdgesVisited;				// counts the number of in edges visited during a DFS
-	int numForwardInEdges;			// number of indges to this node that aren't back edges
-	TimeStamps loopStamps, revLoopStamps;	// used for structuring analysis
-	travType traversed;				// traversal flag for the numerous DFS's
-	CFGNode* next;						// next node in linked list
-	bool hllLabel;						// emit a label for this node when generating HL code?
-	char* labelStr;					// the high level label for this node (if needed)
-	int indentLevel;					// the indentation level of this node in the final code
-
-	// analysis information
+	int loopStamps[2];				// time stamp tuple used for structuring analysis
+	int revLoopStamps[2];			// reverse time stamp tuple (parenthesis structurer only)
 	CFGNode* immPDom;					// immediate post dominator
 	CFGNode* loopHead;				// head of the most nested enclosing loop
 	CFGNode* caseHead;				// head of the most nested enclosing case
 	CFGNode* condFollow;				// follow of a conditional header
 	CFGNode* loopFollow;				// follow of a loop header
 	CFGNode* latchNode;				// latching node of a loop header
+	NodePtrArr outEdges;				// pointers to the nodes on an out edge from this node
 
-	// Structured type of the node
-	structType sType;					// the structuring class (Loop, Cond , etc)
-	unstructType usType;				// the restructured type of a conditional header
-	loopType lType;					// the loop type of a loop header
-	condType cType;					// the conditional type of a conditional header
-#ifdef INTERVALS
-	// Interval membership information
-	CFGNode* interval;
-#endif
+	// Structured type of the node. Each fits in a byte which keeps the node to two lines.
+	bbType type : 8;					// basic block type
+	structType sType : 8;			// the structuring class (Loop, Cond , etc)
+	unstructType usType : 8;		// the restructured type of a conditional header
+	loopType lType : 8;				// the loop type of a loop header
+	condType cType : 8;				// the conditional type of a conditional header
+	travType traversed : 8;			// traversal flag for the numerous DFS's
+
+	NodePtrArr inEdges;				// pointers to the nodes on an in edge to this node
+	int id;								// unique identifier 
+	NodeText* text;					// the instructions and code generation fields
+
+	// Add a statement to list for the non-CTI's (excluding procedure calls) in this
+	// block at the given indentation level
+	void WriteBB(HLLTree &tree, HLLList* list, int indLevel);
 
-	// return the amount of memory taken up by the member instructions excluding non procedure
-	// call CTI's
-	int InsSpace() const;
+	// Carry out the next step in generating the code for this node. Its frame is on top
+	// of the stack.
+	void WriteStep(HLLTree &tree, GenStack &stack, CountedNodeSet &followSet, CountedNodeSet &gotoSet);
 
-	// Write code for the non-CTI's (excluding procedure calls) in this block at
-	// the appropriate indentation level
-	void WriteBB(StrArr &HLLCode, int indLevel);
+	// Mark this node as having (or no longer having) its code generated and update the
+	// count of visited in edges of the nodes it has a forward edge to
+	void SetGenerated();
+	void UnsetGenerated();
 
 	// Return true if every parent of this node has had its code generated
 	bool AllParentsGenerated() const;
 };
 
+// A stack of nodes of one procedure that can be tested for membership in constant
+// time. The number of times each node is on the stack is kept by its order.
+class CountedNodeSet {
+public:
+	CountedNodeSet() : counts(NULL), countsAvail(0) {}
+	~CountedNodeSet() { if (counts) delete[] counts; }
+
+	// Pre: the stack is empty
+	// Post: the stack can hold the nodes of a procedure of numNodes nodes
+	void Init(int numNodes);
+
+	void Add(CFGNode* node) { nodes.Add(node); counts[node->Order()]++; }
+	void RemoveLast() { counts[Last()->Order()]--; nodes.RemoveLast(); }
+	bool IsIn(CFGNode const* node) const { return counts[node->Order()] != 0; }
+	CFGNode* Last() const { return nodes[nodes.Size() - 1]; }
+	int Size() const { return nodes.Size(); }
+
+private:
+	NodePtrArr nodes;					// the nodes in the order they were added
+	int* counts;						// the number of times each node is in nodes
+	int countsAvail;					// the size of counts
+};
+
 #endif
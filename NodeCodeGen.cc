@@ -12,10 +12,9 @@
 //Purpose: provides the operations to generate code for a CFG node that has been
 //		analysed by the structuring algorithms.
 
-#include <math.h>
-#include <stdio.h>
 #include "Graphs.h"
 #include "Node.h"
+#include "HLLTree.h"
 #include "TypeDefs.h"
 #include "StringFunctions.h"
 #include "Options.h"
@@ -23,197 +22,397 @@
 
 extern Options options;
 
-// some constants required to indicate extra code to be added
-#define CLOSE_BRACKET 2		// length of "}\n"
-#define DO_HEADER 5			// length of "do {\n"
-#define ENDLESS_HEADER 11	// langth of "for (;;) {\n"
-
-char* Indent(int indLevel, int extra = 0)
-// Return the string containing indLevel tabstops. 
-// If extra = CLOSE_BRACKET then append "}\n" to the returned string
-// If extra = DO_HEADER then append "do {\n" to the returned string
+void CountedNodeSet::Init(int numNodes)
 {
-	char* retStr = new char[indLevel + extra + 1];
-	memset(retStr,'\t',indLevel);
+	assert(nodes.Size() == 0);
 
-	retStr[indLevel] = '\0';
+	if (numNodes > countsAvail)
+	{
+		if (counts)
+			delete[] counts;
+		counts = new int[countsAvail = numNodes];
+	}
+	for (int i = 0; i < numNodes; i++)
+		counts[i] = 0;
+}
 
-	// add the extra stuff in necessary
-	if (extra == CLOSE_BRACKET)
-		strcat(retStr,"}\n");
-	else if (extra == DO_HEADER)
-		strcat(retStr,"do {\n");
-	else if (extra == ENDLESS_HEADER)
-		strcat(retStr,"for (;;) {\n");
+void CFGNode::InitParentCount()
+{
+	// an in edge is a back edge if this node is its source or an ancestor of it (see
+	// HasBackEdgeTo)
+	text->numForwardInEdges = 0;
+	text->inEdgesVisited = 0;
+	for (int i = 0; i < inEdges.Size(); i++)
+		if (inEdges[i] != this && !IsAncestorOf(inEdges[i]))
+			text->numForwardInEdges++;
+}
 
-	return retStr;
+void CFGNode::SetGenerated()
+{
+	traversed = DFS_CODEGEN;
+	for (int i = 0; i < outEdges.Size(); i++)
+		if (outEdges[i] != this && !outEdges[i]->IsAncestorOf(this))
+			outEdges[i]->text->inEdgesVisited++;
+}
+
+void CFGNode::UnsetGenerated()
+{
+	traversed = UNTRAVERSED;
+	for (int i = 0; i < outEdges.Size(); i++)
+		if (outEdges[i] != this && !outEdges[i]->IsAncestorOf(this))
+			outEdges[i]->text->inEdgesVisited--;
 }
 
 bool CFGNode::AllParentsGenerated() const
 // Return true if every parent (i.e. forward in edge source) of this node has had its code generated
 {
-	for (int i = 0; i < inEdges.Size(); i++)
-		if (!inEdges[i]->HasBackEdgeTo(this) && inEdges[i]->traversed != DFS_CODEGEN)
-			return false;
-	return true;
+	return text->inEdgesVisited == text->numForwardInEdges;
 }
 
-void CFGNode::EmitGotoAndLabel(StrArr &HLLCode, int indLevel, CFGNode* dest)
-// Emits a goto statement (at the correct indentation level) with the destination label for dest.
+void CFGNode::EmitGotoAndLabel(HLLTree &tree, HLLList* list, CFGNode* dest)
+// Adds a goto statement with the destination label for dest.
 // Also places the label just before the destination code if it isn't already there.
-// If the goto is to the return block, emit a 'return' instead.
+// If the goto is to the return block, add a 'return' instead.
 // Also, 'continue' and 'break' statements are used instead if possible
 {
 	// is this a goto to the ret block?
-	if (dest->type == ret && dest->instructs.Size() == 2)
+	if (dest->type == ret && dest->text->instructs.Size() == 2)
 	{
 		// get the delayed instruction from the return block which will always be the second and last
 		// instruction in the block
-		char const* delayedIns = dest->instructs[1]->GetString();
-		char* retStmt = new char[indLevel * 2 + strlen("return;\n\n") + strlen(delayedIns) + 1];
-
-		sprintf(retStmt,"%s%s\n%sreturn;\n",Indent(indLevel),delayedIns,Indent(indLevel));
-		HLLCode.Add(retStmt);
+		tree.Add(list, ReturnStmt)->delayed = dest->text->instructs[1];
 	}
 	else
 	{
-		char* gotoStmt;
-
 		if (loopHead && (loopHead == dest || loopHead->loopFollow == dest))
 		{
-			gotoStmt = new char[indLevel + strlen("continue;\n") + 1];
-			sprintf(gotoStmt,"%s%s\n",Indent(indLevel),(loopHead == dest ? "continue;" : "break;"));
+			tree.Add(list, loopHead == dest ? ContinueStmt : BreakStmt);
 #ifdef GETSTATS
 			stats.numContBrks++;
 #endif
 		}
 		else
 		{
- 			gotoStmt = new char[indLevel + strlen("goto L;\n") + 
-								(dest->ord == 0 ? 1 : static_cast<int>(ceil(log10(dest->ord)))) + 1];
-			sprintf(gotoStmt,"%sgoto L%d;\n",Indent(indLevel),dest->ord);
+			tree.Add(list, GotoStmt)->num = dest->ord;
 
 			// don't emit the label if it already has been emitted or the code 
 			// for the destination has not yet been generated
-			if (!dest->hllLabel && dest->traversed == DFS_CODEGEN)
-				sprintf(dest->labelStr,"L%d:\n",dest->ord);
+			if (!dest->text->hllLabel && dest->traversed == DFS_CODEGEN)
+				dest->text->labelStmt->label = true;
 
-			dest->hllLabel = true;
+			dest->text->hllLabel = true;
 #ifdef GETSTATS
 			stats.numGotos++;
 #endif
 		}
-		HLLCode.Add(gotoStmt);
 	}
 }
 
 //************************************************************************
 // Generate code for body of a basic block
 //************************************************************************
-void CFGNode::WriteBB(StrArr &HLLCode, int indLevel)
-// Generates code for each non CTI (except procedure calls) statement within the block.
+void CFGNode::WriteBB(HLLTree &tree, HLLList* list, int indLevel)
+// Adds the statement for each non CTI (except procedure calls) within the block.
 {
-	// allocate space for a label to be generated for this node and add this to
-	// the generated code. The actual label can then be generated now or back patched later
-	int labelSize = (ord == 0 ? 1 : static_cast<int>(ceil(log10(ord)))) + strlen("L:\n") + 1;
-	labelStr = new char[labelSize];
-	HLLCode.Add(labelStr);
-	if (hllLabel)
-		sprintf(labelStr,"L%d:\n",ord);
-	else
-		strcpy(labelStr,"");
+	HLLStmt* stmt = tree.Add(list, BlockStmt);
+	stmt->num = ord;
+	stmt->instructs = &text->instructs;
+
+	// if the 2nd last instruction in a block is a non-procedure call CTI, then leave
+	// it out
+	if (text->instructs.Size() >= 2 && GetCTI() && type != call)
+		stmt->skip = text->instructs.Size() - 2;
+
+	// remember the statement the label for this node goes before. The label can then
+	// be set now or back patched later
+	text->labelStmt = stmt;
+	stmt->label = text->hllLabel;
 #ifdef GETSTATS
 	stats.maxIndent = (stats.maxIndent < indLevel ? indLevel : stats.maxIndent);
 #endif
-	
-	if (options.blocksOnly)
-	{
-		char* codeString = new char[indLevel + 20];
-		sprintf(codeString,"%sBB%d;\n",Indent(indLevel),ord);
-		HLLCode.Add(codeString);
-	}
-	else
-	{
-		// allocate the space required by all the non-procedure call, non-CTI's in the block
-		char* codeString = new char[indLevel * instructs.Size() + InsSpace()];
 
-		// initialise the string
-		codeString[0] = '\0';
+	// save the indentation level that this node was written at
+	text->indentLevel = indLevel;
+}
+
+//*********************************************************************
+// The stack of pending code generation steps
+//*********************************************************************
 
-		for (int i = 0; i < instructs.Size(); i++)
-			// if this is the 2nd last instruction in a block delimited by a non-procedure
-			// call CTI, then don't print out this CTI
-			if (!(i == instructs.Size() - 2 && GetCTI() && type != call))
-				sprintf(codeString,"%s%s%s\n",codeString,Indent(indLevel),instructs[i]->GetString());
-		
-		// add the code for this block to the code for the procedure
-		HLLCode.Add(codeString);	
+// the initial number of frames in the stack
+#define GEN_STACK_INIT 64
+
+// The steps that generate the code for a node. A step that needs the code of
+// another node to be generated first sets the step of its frame to the one to be
+// carried out once that is done and pushes a frame for the other node.
+enum genStep {
+	GenNode,				// enter the node as the old recursive WriteCode did
+	GenPreTestedEnd,	// the body of a pre-tested loop has been generated
+	GenLoopEnd,			// the body of a post-tested or endless loop has been generated
+	GenLoopFollow,		// visit the follow of a loop
+	GenCondThen,		// the first clause of a 2 way conditional has been generated
+	GenCaseArm,			// open the next arm of a case
+	GenCondClose		// close a conditional and visit its follow
+};
+
+// a frame holds what a call of the recursive WriteCode kept on the native stack
+struct GenFrame {
+	CFGNode* node;						// the node whose code is being generated
+	HLLList* list;						// the list its statements are added to
+	int indLevel;						// the indentation level of its code
+	CFGNode const* latch;			// the latch of the most nested enclosing loop
+	genStep step;						// the next step for the node
+	CFGNode* tmpCondFollow;			// the follow used by an unstructured conditional
+	int gotoTotal;						// the number of nodes the node added to the goto set
+	int caseArm;						// the next out edge of a case header
+	HLLStmt* stmt;						// the loop or conditional statement of the node
+};
+
+class GenStack {
+public:
+	GenStack() : frames(new GenFrame[GEN_STACK_INIT]), sz(0), avail(GEN_STACK_INIT) {}
+	~GenStack() { delete[] frames; }
+
+	// push a frame to enter node. NOTE: this can move the frames so a reference to
+	// the top frame must not be used after a push.
+	void Push(CFGNode* node, HLLList* list, int indLevel, CFGNode const* latch);
+
+	// pop the top frame
+	void Pop() { sz--; }
+
+	// replace the top frame with one to enter node, adding to the same list. This
+	// takes the place of a recursive call that is the last thing done for a node.
+	void Replace(CFGNode* node, int indLevel, CFGNode const* latch) { sz--; Push(node, frames[sz].list, indLevel, latch); }
+
+	GenFrame& Top() const { return frames[sz - 1]; }
+	int Size() const { return sz; }
+
+private:
+	GenFrame* frames;
+	int sz;
+	int avail;
+};
+
+void GenStack::Push(CFGNode* node, HLLList* list, int indLevel, CFGNode const* latch)
+{
+	if (sz == avail)
+	{
+		GenFrame* newFrames = new GenFrame[avail * 2];
+		memcpy(newFrames, frames, sz * sizeof(GenFrame));
+		delete[] frames;
+		frames = newFrames;
+		avail *= 2;
 	}
-
-	// save the indentation level that this node was written at
-	indentLevel = indLevel;
+	GenFrame &f = frames[sz++];
+	f.node = node;
+	f.list = list;
+	f.indLevel = indLevel;
+	f.latch = latch;
+	f.step = GenNode;
+	f.tmpCondFollow = NULL;
+	f.gotoTotal = 0;
+	f.caseArm = 0;
+	f.stmt = NULL;
 }
 
 //*********************************************************************
 // Generate code for control flow info for each basic block
 //*********************************************************************
-void CFGNode::WriteCode(StrArr &HLLCode, int indLevel, CFGNode const* latch, NodePtrArr &followSet, NodePtrArr &gotoSet)
+void CFGNode::WriteCode(HLLTree &tree, HLLList* list, int indLevel, CFGNode const* latch, CountedNodeSet &followSet, CountedNodeSet &gotoSet)
+// The code is generated with an explicit stack of steps rather than by recursion
+// so that the depth of the structure isn't limited by the size of the native stack.
+{
+	GenStack stack;
+
+	stack.Push(this, list, indLevel, latch);
+	while (stack.Size())
+		stack.Top().node->WriteStep(tree, stack, followSet, gotoSet);
+}
+
+void CFGNode::WriteStep(HLLTree &tree, GenStack &stack, CountedNodeSet &followSet, CountedNodeSet &gotoSet)
+// Pre: the frame on top of stack is for this node
 {
+	GenFrame &f = stack.Top();
+	HLLList* list = f.list;
+	int indLevel = f.indLevel;
+	CFGNode const* latch = f.latch;
+	HLLStmt* stmt;
+	CFGNode* succ;
+
+	// a latch that isn't within its own loop (as when the loop was found in an irreducible
+	// graph by the reverse loop stamps only) is treated as if no loop is being generated
+	if (latch && !latch->loopHead)
+		latch = NULL;
+
+	switch (f.step) {
+	case GenNode:
+		break;
+
+	case GenPreTestedEnd:
+		// if code has not been generated for the latch node, generate it now
+		if (latchNode->traversed != DFS_CODEGEN)
+		{
+			latchNode->SetGenerated();
+			latchNode->WriteBB(tree, f.stmt->parts, indLevel+1);
+		}
+
+		// rewrite the body of the block (excluding the predicate) at the next nesting level
+		// after making sure another label won't be generated
+		text->hllLabel = false;
+		WriteBB(tree, f.stmt->parts, indLevel+1);
+		f.step = GenLoopFollow;
+		return;
+
+	case GenLoopEnd:
+		// if code has not been generated for the latch node, generate it now
+		if (latchNode->traversed != DFS_CODEGEN)
+		{
+			latchNode->SetGenerated();
+			latchNode->WriteBB(tree, f.stmt->parts, indLevel+1);
+		}
+
+		// the repeat loop predicate is that of the latch
+		if (lType == PostTested)
+			f.stmt->cond = Type2String(latchNode->GetCTI()->GetType());
+		else
+			assert(lType == Endless);
+		f.step = GenLoopFollow;
+		return;
+
+	case GenLoopFollow:
+		// write the code for the follow of the loop (if it exists)
+		if (loopFollow)
+		{
+			// remove the follow from the follow set
+			followSet.RemoveLast();
+
+			if (loopFollow->traversed != DFS_CODEGEN)
+			{
+				stack.Replace(loopFollow, indLevel, latch);
+				return;
+			}
+			else
+				EmitGotoAndLabel(tree, list, loopFollow);
+		}
+		stack.Pop();
+		return;
+
+	case GenCondThen:
+		// generate the else clause if necessary
+		f.step = GenCondClose;
+		if (cType == IfThenElse)
+		{
+			succ = outEdges[ELSE];
+
+			// emit a goto statement if the second clause has already been generated
+			if (succ->traversed == DFS_CODEGEN)
+				 EmitGotoAndLabel(tree, &f.stmt->parts[ELSE], succ);
+			else
+				stack.Push(succ, &f.stmt->parts[ELSE], indLevel + 1, latch);
+		}	
+		return;
+
+	case GenCaseArm:
+		// generate code for the next out branch
+		if (f.caseArm == outEdges.Size())
+		{
+			f.step = GenCondClose;
+			return;
+		}
+
+		// generate code for the current outedge into its arm
+		list = &f.stmt->parts[f.caseArm];
+		succ = outEdges[f.caseArm++];
+//		assert(succ->caseHead == this || succ == condFollow || HasBackEdgeTo(succ));
+		if (succ->traversed == DFS_CODEGEN)
+			EmitGotoAndLabel(tree, list, succ);
+		else
+			stack.Push(succ, list, indLevel + 1, latch);
+		return;
+
+	case GenCondClose:
+		// do all the follow stuff if this conditional had one
+		if (condFollow)
+		{
+			// remove the original follow from the follow set if it was added by this header
+			if (usType == Structured || usType == JumpIntoCase)
+			{
+				assert(f.gotoTotal == 0);
+				followSet.RemoveLast();
+			}
+
+			// else remove all the nodes added to the goto set
+			else
+				for (int i = 0; i < f.gotoTotal; i++)
+					gotoSet.RemoveLast();
+
+			// do the code generation (or goto emitting) for the new conditional follow if it exists
+			// otherwise do it for the original follow
+			CFGNode* tmpCondFollow = (f.tmpCondFollow ? f.tmpCondFollow : condFollow);
+			
+			if (tmpCondFollow->traversed == DFS_CODEGEN)
+				EmitGotoAndLabel(tree, list, tmpCondFollow);
+			else
+			{
+				stack.Replace(tmpCondFollow, indLevel, latch);
+				return;
+			}
+		}
+		stack.Pop();
+		return;
+	}
+
 	// If this is the follow for the most nested enclosing conditional, then
 	// don't generate anything. Otherwise if it is in the follow set
 	// generate a goto to the follow
-	CFGNode* enclFollow = static_cast<CFGNode*>(followSet.Size() == 0 ? NULL : followSet[followSet.Size() - 1]);
+	CFGNode* enclFollow = (followSet.Size() == 0 ? NULL : followSet.Last());
 
 	if (gotoSet.IsIn(this) && !IsLatchNode() && ((latch && this == latch->loopHead->loopFollow) || !AllParentsGenerated()))
 	{
-		EmitGotoAndLabel(HLLCode, indLevel, this);
+		EmitGotoAndLabel(tree, list, this);
+		stack.Pop();
 		return;
 	}
 	else if (followSet.IsIn(this))
 	{
 		if (this != enclFollow)
-		{
-			EmitGotoAndLabel(HLLCode, indLevel, this);
-			return;
-		}
-		else
-			return;
+			EmitGotoAndLabel(tree, list, this);
+		stack.Pop();
+		return;
 	}
 
 	// Has this node already been generated?
 	if (traversed == DFS_CODEGEN)
 	{
-		// this should only occur for a loop over a single block
-		assert(sType == Loop && lType == PostTested && latchNode == this);
+		// a loop over a single block comes back to itself. Any other node is being
+		// reached again through another entry into an irreducible region, so jump to it.
+		if (sType != Loop || lType != PostTested || latchNode != this)
+			EmitGotoAndLabel(tree, list, this);
+		stack.Pop();
 		return;
 	}
 	else
-		traversed = DFS_CODEGEN;
+		SetGenerated();
 
 	// if this is a latchNode and the current indentation level is
 	// the same as the first node in the loop, then this write out its body and return
-	// otherwise generate a goto
+	// otherwise generate a goto. A latch can be reached outside of any loop once the
+	// loops of a split graph have been found from its derived sequence.
 	if (IsLatchNode())
-		if (indLevel == latch->loopHead->indentLevel + (latch->loopHead->lType == PreTested ? 1 : 0))
-		{
-			WriteBB(HLLCode, indLevel);
-			return;
-		}
+	{
+		if (latch && indLevel == latch->loopHead->text->indentLevel + (latch->loopHead->lType == PreTested ? 1 : 0))
+			WriteBB(tree, list, indLevel);
 		else
 		{
 			// unset its traversed flag
-			traversed = UNTRAVERSED;
+			UnsetGenerated();
 
-			EmitGotoAndLabel(HLLCode, indLevel, this);
-			return;
+			EmitGotoAndLabel(tree, list, this);
 		}
+		stack.Pop();
+		return;
+	}
 	
-	// declare some strings that can't be initialised in the body of the switch
-	char* condPred;
-	char* predString;
-	char* opCode;
-	char* retStmt;
-
 	switch(sType) {
 	case Loop:
 	case LoopCond:
@@ -227,114 +426,53 @@ void CFGNode::WriteCode(StrArr &HLLCode, int indLevel, CFGNode const* latch, Nod
 			assert(latchNode->outEdges.Size() == 1);
 
 			// write the body of the block (excluding the predicate)
-			WriteBB(HLLCode, indLevel);
+			WriteBB(tree, list, indLevel);
 
-			// write the 'while' predicate
-			//opCode = static_cast<char*>(Type2String(GetCTI()->GetType()));
-			opCode = (char*)(Type2String(GetCTI()->GetType()));
-			predString = new char[(indLevel * 2) + 1 + strlen("while (") + MAX_OPCODE_LEN + strlen(")\n") + strlen("{\n") + 1];
-			sprintf(predString,"%swhile (%s%s)\n%s{\n",Indent(indLevel),(outEdges[THEN] == loopFollow ? "!" : ""),opCode,Indent(indLevel));
-			HLLCode.Add(predString);
+			// add the 'while' loop with its predicate
+			stmt = f.stmt = tree.Add(list, WhileStmt);
+			stmt->cond = Type2String(GetCTI()->GetType());
+			stmt->negate = (outEdges[THEN] == loopFollow);
+			tree.AddParts(stmt, 1);
 
 #ifdef GETSTATS
 			stats.numLoops++;
 #endif
 
-			// write the code for the body of the loop
+			// write the code for the body of the loop, then the rest of the loop
 			CFGNode* loopBody = (outEdges[ELSE] == loopFollow) ? outEdges[THEN] : outEdges[ELSE];
-			loopBody->WriteCode(HLLCode, indLevel + 1, latchNode, followSet, gotoSet);
-
-			// if code has not been generated for the latch node, generate it now
-			if (latchNode->traversed != DFS_CODEGEN)
-			{
-				latchNode->traversed = DFS_CODEGEN;
-				latchNode->WriteBB(HLLCode, indLevel+1);
-			}
-
-			// rewrite the body of the block (excluding the predicate) at the next nesting level
-			// after making sure another label won't be generated
-			hllLabel = false;
-			WriteBB(HLLCode, indLevel+1);
-
-			// write the loop tail
-			HLLCode.Add(Indent(indLevel,CLOSE_BRACKET));
+			f.step = GenPreTestedEnd;
+			stack.Push(loopBody, stmt->parts, indLevel + 1, latchNode);
 		}
 		else 
 		{
 
-			// write the loop header
-			if (lType == Endless)
-				HLLCode.Add(Indent(indLevel,ENDLESS_HEADER));
-			else
-				HLLCode.Add(Indent(indLevel,DO_HEADER));
+			// add the loop. The predicate of a repeat loop is set once its body is done.
+			stmt = f.stmt = tree.Add(list, lType == Endless ? ForStmt : DoWhileStmt);
+			tree.AddParts(stmt, 1);
 #ifdef GETSTATS
 			stats.numLoops++;
 #endif
 
 			// if this is also a conditional header, then generate code for the
-			// conditional. Otherwise generate code for the loop body.
+			// conditional. Otherwise generate code for the loop body. The rest of the
+			// loop is written once that is done.
+			f.step = GenLoopEnd;
 			if (sType == LoopCond)
 			{
-				// set the necessary flags so that WriteCode can successfully be called
-				// again on this node
+				// set the necessary flags so that this node can successfully be entered
+				// again
 				sType = Cond;
-				traversed = UNTRAVERSED;
+				UnsetGenerated();
 				
-				WriteCode(HLLCode, indLevel + 1, latchNode, followSet, gotoSet);
+				stack.Push(this, stmt->parts, indLevel + 1, latchNode);
 			}
 			else
 			{
-				WriteBB(HLLCode, indLevel+1);
+				WriteBB(tree, stmt->parts, indLevel+1);
 
 				// write the code for the body of the loop
-				outEdges[0]->WriteCode(HLLCode, indLevel + 1, latchNode, followSet, gotoSet);
-			}
-
-			if (lType == PostTested)
-			{
-
-				// if code has not been generated for the latch node, generate it now
-				if (latchNode->traversed != DFS_CODEGEN)
-				{
-					latchNode->traversed = DFS_CODEGEN;
-					latchNode->WriteBB(HLLCode, indLevel+1);
-				}
-			
-				// string for the repeat loop predicate.
-				predString = new char[indLevel + strlen("} while (") + MAX_OPCODE_LEN + strlen(")\n") + 2];
-
-				// write the repeat loop predicate
-				//opCode = static_cast<char*>(Type2String(latchNode->GetCTI()->GetType()));
-				opCode = (char*)(Type2String(latchNode->GetCTI()->GetType()));
-				sprintf(predString,"%s} while (%s);\n",Indent(indLevel),opCode);
-				HLLCode.Add(predString);
+				stack.Push(outEdges[0], stmt->parts, indLevel + 1, latchNode);
 			}
-			else
-			{
-				assert(lType == Endless);
-
-				// if code has not been generated for the latch node, generate it now
-				if (latchNode->traversed != DFS_CODEGEN)
-				{
-					latchNode->traversed = DFS_CODEGEN;
-					latchNode->WriteBB(HLLCode, indLevel+1);
-				}
-
-				// write the closing bracket for an endless loop
-				HLLCode.Add(Indent(indLevel,CLOSE_BRACKET));
-			}
-		}
-
-		// write the code for the follow of the loop (if it exists)
-		if (loopFollow)
-		{
-			// remove the follow from the follow set
-			followSet.RemoveLast();
-
-			if (loopFollow->traversed != DFS_CODEGEN)
-				loopFollow->WriteCode(HLLCode, indLevel, latch, followSet, gotoSet);
-			else
-				EmitGotoAndLabel(HLLCode, indLevel,loopFollow);
 		}
 		break;
 
@@ -345,14 +483,9 @@ void CFGNode::WriteCode(StrArr &HLLCode, int indLevel, CFGNode const* latch, Nod
 			sType = LoopCond;
 
 		// for 2 way conditional headers that are effectively jumps into or out of a
-		// loop or case body, we will need a new follow node
-		CFGNode* tmpCondFollow;
-		tmpCondFollow = NULL;
-
-		// keep track of how many nodes were added to the goto set so that the correct number
-		// are removed
-		int gotoTotal;
-		gotoTotal = 0;
+		// loop or case body, we will need a new follow node (f.tmpCondFollow). The
+		// number of nodes added to the goto set is kept in f.gotoTotal so that the
+		// correct number are removed.
 
 		// add the follow to the follow set if this is a case header
 		if (cType == Case)
@@ -361,9 +494,6 @@ void CFGNode::WriteCode(StrArr &HLLCode, int indLevel, CFGNode const* latch, Nod
 		else if (cType != Case && condFollow)
 		{
 			// For a structured two conditional header, its follow is added to the follow set
-			CFGNode* myLoopHead;
-			myLoopHead = (sType == LoopCond ? this : loopHead);
-
 			if (usType == Structured)
 				followSet.Add(condFollow);
 	
@@ -378,50 +508,48 @@ void CFGNode::WriteCode(StrArr &HLLCode, int indLevel, CFGNode const* latch, Nod
 					CFGNode* myLoopHead = (sType == LoopCond ? this : loopHead);
 
 					gotoSet.Add(condFollow);
-					gotoTotal++;
+					f.gotoTotal++;
 	
 					// also add the current latch node, and the loop header of the follow if they exist
 					if (latch)
 					{
-						//gotoSet.Add(static_cast<CFGNode*>(latch));
 						gotoSet.Add((CFGNode*)(latch));
-						gotoTotal++;
+						f.gotoTotal++;
 					}
 					if (condFollow->loopHead && condFollow->loopHead != myLoopHead)
 					{
 						gotoSet.Add(condFollow->loopHead);
-						gotoTotal++;
+						f.gotoTotal++;
 					}
 				}
 
 				if (cType == IfThen)
-					tmpCondFollow = outEdges[ELSE];
+					f.tmpCondFollow = outEdges[ELSE];
 				else
-					tmpCondFollow = outEdges[THEN];
+					f.tmpCondFollow = outEdges[THEN];
 
 				// for a jump into a case, the temp follow is added to the follow set
 				if (usType == JumpIntoCase)
-					followSet.Add(tmpCondFollow);
+					followSet.Add(f.tmpCondFollow);
 			}
 		}
 
 		// write the body of the block (excluding the predicate)
-		WriteBB(HLLCode, indLevel);
+		WriteBB(tree, list, indLevel);
 
-		// write the conditional header 
+		// add the conditional statement. A case has an arm for each out edge.
 		if (cType == Case)
 		{
-			condPred = new char[indLevel * 2 + strlen("switch (!") + MAX_OPCODE_LEN + strlen(") {\n") + 1];
-			sprintf(condPred,"%sswitch (%s) {\n",Indent(indLevel),"Reg0");
+			stmt = f.stmt = tree.Add(list, SwitchStmt);
+			tree.AddParts(stmt, outEdges.Size());
 		}
 		else
 		{
-			//opCode = static_cast<char*>(Type2String(GetCTI()->GetType()));
-			opCode = (char*)(Type2String(GetCTI()->GetType()));
-			condPred = new char[indLevel * 2 + strlen("switch (!") + MAX_OPCODE_LEN + strlen(") {\n") + 1];
-			sprintf(condPred,"%sif (%s%s) {\n",Indent(indLevel),(cType == IfElse ? "!" : ""),opCode);
+			stmt = f.stmt = tree.Add(list, IfStmt);
+			stmt->cond = Type2String(GetCTI()->GetType());
+			stmt->negate = (cType == IfElse);
+			tree.AddParts(stmt, cType == IfThenElse ? 2 : 1);
 		}
-		HLLCode.Add(condPred);
 
 		// write code for the body of the conditional
 		if (cType != Case)
@@ -431,31 +559,15 @@ void CFGNode::WriteCode(StrArr &HLLCode, int indLevel, CFGNode const* latch, Nod
 			stats.num2ways++;
 #endif
 
-			CFGNode* succ = (cType == IfElse ? outEdges[ELSE] : outEdges[THEN]);
+			succ = (cType == IfElse ? outEdges[ELSE] : outEdges[THEN]);
 
 			// emit a goto statement if the first clause has already been generated or it
 			// is the follow of this node's enclosing loop
+			f.step = GenCondThen;
 			if (succ->traversed == DFS_CODEGEN || (loopHead && succ == loopHead->loopFollow))
-				EmitGotoAndLabel(HLLCode, indLevel + 1, succ);
+				EmitGotoAndLabel(tree, &stmt->parts[THEN], succ);
 			else	
-				succ->WriteCode(HLLCode, indLevel + 1, latch, followSet, gotoSet);
-
-			// generate the else clause if necessary
-			if (cType == IfThenElse)
-			{
-				// generate the 'else' keyword and matching brackets
-				char* elseStr = new char[indLevel * 2 + strlen("} else\n{\n") + 1];
-				sprintf(elseStr,"%s} else\n%s{\n",Indent(indLevel),Indent(indLevel));
-				HLLCode.Add(elseStr);
-
-				succ = outEdges[ELSE];
-
-				// emit a goto statement if the second clause has already been generated
-				if (succ->traversed == DFS_CODEGEN)
-					 EmitGotoAndLabel(HLLCode, indLevel + 1, succ);
-				else
-					succ->WriteCode(HLLCode, indLevel + 1, latch, followSet, gotoSet);
-			}	
+				stack.Push(succ, &stmt->parts[THEN], indLevel + 1, latch);
 		}
 		else		// case header
 		{
@@ -464,70 +576,20 @@ void CFGNode::WriteCode(StrArr &HLLCode, int indLevel, CFGNode const* latch, Nod
 			stats.numNways++;
 #endif
 
-			// generate code for each out branch
-			for (int i = 0; i < outEdges.Size(); i++)
-			{
-				// emit a case label
-				char* caseStr = new char[indLevel + strlen("cond_:\n") + (i == 0 ? 1 : static_cast<int>(ceil(log10(i)))) + 1];
-				sprintf(caseStr,"%scase cond_%d:\n",Indent(indLevel),i);
-				HLLCode.Add(caseStr);
-
-				// generate code for the current outedge
-				CFGNode* succ = outEdges[i];
-//				assert(succ->caseHead == this || succ == condFollow || HasBackEdgeTo(succ));
-				if (succ->traversed == DFS_CODEGEN)
-					EmitGotoAndLabel(HLLCode, indLevel + 1, succ);
-				else
-					succ->WriteCode(HLLCode, indLevel + 1, latch, followSet, gotoSet);
-
-				// generate the 'break' statement
-				caseStr = new char[indLevel + 1 + strlen("break;\n") + 1];
-				sprintf(caseStr,"%sbreak;\n",Indent(indLevel + 1));
-				HLLCode.Add(caseStr);
-			}
-		}
-
-		// generate the closing bracket
-		HLLCode.Add(Indent(indLevel,CLOSE_BRACKET));
-
-		// do all the follow stuff if this conditional had one
-		if (condFollow)
-		{
-			// remove the original follow from the follow set if it was added by this header
-			if (usType == Structured || usType == JumpIntoCase)
-			{
-				assert(gotoTotal == 0);
-				followSet.RemoveLast();
-			}
-
-			// else remove all the nodes added to the goto set
-			else
-				for (int i = 0; i < gotoTotal; i++)
-					gotoSet.RemoveLast();
-
-			// do the code generation (or goto emitting) for the new conditional follow if it exists
-			// otherwise do it for the original follow
-			if (!tmpCondFollow)
-				tmpCondFollow = condFollow;
-			
-			if (tmpCondFollow->traversed == DFS_CODEGEN)
-				EmitGotoAndLabel(HLLCode, indLevel, tmpCondFollow);
-			else
-				tmpCondFollow->WriteCode(HLLCode, indLevel,latch,followSet, gotoSet);
+			// the out branches are generated one at a time
+			f.step = GenCaseArm;
 		}
-
 		break;
 	
 	case Seq:
 		// generate code for the body of this block
-		WriteBB(HLLCode, indLevel);
+		WriteBB(tree, list, indLevel);
 
 		// return if this is the 'return' block (i.e. has no out edges) after emmitting a 'return' statement
 		if (type == ret)
 		{
-			retStmt = new char[indLevel + strlen("return;\n") + 1];
-			sprintf(retStmt,"%sreturn;\n",Indent(indLevel));
-			HLLCode.Add(retStmt);
+			tree.Add(list, ReturnStmt);
+			stack.Pop();
 			return;
 		}
 
@@ -540,10 +602,12 @@ void CFGNode::WriteCode(StrArr &HLLCode, int indLevel, CFGNode const* latch, Nod
 			(!child->AllParentsGenerated() || followSet.IsIn(child))) ||
 			(latch && latch->loopHead->loopFollow == child) ||
 		!(caseHead == child->caseHead || (caseHead && child == caseHead->condFollow)))
-
-			EmitGotoAndLabel(HLLCode, indLevel, outEdges[0]);
+		{
+			EmitGotoAndLabel(tree, list, outEdges[0]);
+			stack.Pop();
+		}
 		else
-			outEdges[0]->WriteCode(HLLCode, indLevel,latch,followSet, gotoSet);
+			stack.Replace(outEdges[0], indLevel, latch);
 
 		break;
 	}
@@ -15,8 +15,140 @@
 
 #include <iostream.h>
 #include <stdlib.h>
+#include <string.h>
 #include "Options.h"
 
+// the default number of instructions that may be duplicated in a procedure when
+// splitting the nodes of an irreducible graph
+#define DEFAULT_SPLIT_BUDGET 500
+
+// the default number of slowest procedures displayed with the metrics of each procedure
+#define DEFAULT_PROC_TOP 10
+
+// the long arguments whose value is a number that isn't negative
+static char const* countArgs[] = { "split", "threads", "dot-min", "dot-depth", "proc-top" };
+
+#define NUM_COUNT_ARGS (int)(sizeof(countArgs) / sizeof(countArgs[0]))
+
+// is value a number that isn't negative?
+static bool IsCount(char const* value)
+{
+	return *value && strspn(value,"0123456789") == strlen(value);
+}
+
+static void BadArg(char const* arg)
+{
+	cerr << " Bad command line argument: --" << arg << endl;
+	cerr << " Run the program without any arguments to see the available options." << endl;
+	exit(1);
+}
+
+int Options::Formats(char* value)
+{
+	int formats = 0;
+
+	for (char* name = strtok(value,","); name; name = strtok(NULL,","))
+		if (strcmp(name,"hll") == 0)
+			formats |= CFormat;
+		else if (strcmp(name,"json") == 0)
+			formats |= JSONFormat;
+		else if (strcmp(name,"bin") == 0)
+			formats |= BinFormat;
+		else
+			return 0;
+	return formats;
+}
+
+int Options::Exports(char* value)
+{
+	int formats = 0;
+
+	for (char* name = strtok(value,","); name; name = strtok(NULL,","))
+		if (strcmp(name,"csr") == 0)
+			formats |= CSRExport;
+		else if (strcmp(name,"jsonl") == 0)
+			formats |= JSONLExport;
+		else
+			return 0;
+	return formats;
+}
+
+void Options::LongArg(char* arg)
+{
+	// separate the value (if any) from the name of the argument
+	char* value = strchr(arg,'=');
+	if (value)
+		*value++ = '\0';
+
+	// check the value of any argument that is a number once here
+	for (int i = 0; i < NUM_COUNT_ARGS; i++)
+		if (strcmp(arg,countArgs[i]) == 0 && value && !IsCount(value))
+			BadArg(arg);
+
+	if (strcmp(arg,"split") == 0)
+	{
+		splitNodes = true;
+		if (value)
+			splitBudget = atoi(value);
+	}
+	else if (strcmp(arg,"structurer") == 0 && value && strcmp(value,"parens") == 0)
+		structAlg = Parens;
+	else if (strcmp(arg,"structurer") == 0 && value && strcmp(value,"intervals") == 0)
+		structAlg = Intervals;
+	else if (strcmp(arg,"diff") == 0 && !value)
+		diffStruct = true;
+	else if (strcmp(arg,"threads") == 0 && value && atoi(value) > 0)
+		numThreads = atoi(value);
+	else if (strcmp(arg,"format") == 0 && value && (codeFormats = Formats(value)))
+		genCode = true;
+	else if (strcmp(arg,"dot") == 0 && value && strcmp(value,"single") == 0)
+	{
+		dotMode = DotSingle;
+		genDotty = true;
+	}
+	else if (strcmp(arg,"dot") == 0 && value && strcmp(value,"split") == 0)
+	{
+		dotMode = DotSplit;
+		genDotty = true;
+	}
+	else if (strcmp(arg,"dot") == 0 && value && strcmp(value,"clusters") == 0)
+	{
+		dotMode = DotClusters;
+		genDotty = true;
+	}
+	else if (strcmp(arg,"dot-proc") == 0 && value && *value)
+	{
+		dotProc = value;
+		genDotty = true;
+	}
+	else if (strcmp(arg,"dot-min") == 0 && value)
+	{
+		dotMinSize = atoi(value);
+		genDotty = true;
+	}
+	else if (strcmp(arg,"dot-depth") == 0 && value)
+	{
+		dotDepth = atoi(value);
+		genDotty = true;
+	}
+	else if (strcmp(arg,"proc-stats") == 0 && value && strcmp(value,"csv") == 0)
+		procStats = CSVProcStats;
+	else if (strcmp(arg,"proc-stats") == 0 && value && strcmp(value,"jsonl") == 0)
+		procStats = JSONLProcStats;
+	else if (strcmp(arg,"proc-top") == 0 && value)
+		procTop = atoi(value);
+	else if (strcmp(arg,"perf") == 0 && !value)
+		perfCounters = true;
+	else if (strcmp(arg,"stats") == 0 && value && strcmp(value,"json") == 0)
+		statsJSON = true;
+	else if (strcmp(arg,"trace") == 0 && value && *value)
+		traceFile = value;
+	else if (strcmp(arg,"export") == 0 && value && (exportFormats = Exports(value)))
+		;
+	else
+		BadArg(arg);
+}
+
 
 char* Options::InitArgs(int argc, char *argv[])
 {
@@ -32,8 +164,32 @@ char* Options::InitArgs(int argc, char *argv[])
 	genCode     = false;
 	genDotty    = false;
 	blocksOnly  = false;
+	splitNodes  = false;
+	splitBudget = DEFAULT_SPLIT_BUDGET;
+	structAlg   = Parens;
+	diffStruct  = false;
+	numThreads  = 1;
+	codeFormats = CFormat;
+	dotMode     = DotSingle;
+	dotProc     = NULL;
+	dotMinSize  = 0;
+	dotDepth    = -1;
+	exportFormats = 0;
+	statsJSON   = false;
+	traceFile   = NULL;
+	perfCounters = false;
+	procStats   = NoProcStats;
+	procTop     = DEFAULT_PROC_TOP;
 	
 	while (--argc > 0 && (*++argv)[0] == '-')
+	{
+		// long arguments begin with "--"
+		if (argv[0][1] == '-')
+		{
+			LongArg(argv[0] + 2);
+			continue;
+		}
+
 		for (pc = argv[0] + 1; *pc; pc++)
 			switch (*pc) {
 			case 'c':
@@ -70,31 +226,68 @@ char* Options::InitArgs(int argc, char *argv[])
 				cerr << " Run the program without any arguments to see the available options." << endl;
 				exit(1);
 				break;
-			}	
+			}
+	}
 
 	// return the filename
-	if (argc == 1)
-		return *argv;
-	else
-	{
-		cerr << "Usage: " << progname << " [-cgdsphr] Sparc_asm_file" << endl;
-		cerr << "\t-c generate the high level code" << endl;
-		cerr << "\t-g remove unecessary goto's from the generated code";
-		cerr << " (currently unavailable)" << endl;
-		cerr << "\t-d generate the graphviz output" << endl;
-		cerr << endl;
-		cerr << "\tThe following option implies -c" << endl;
-		cerr << endl;
-		cerr << "\t-b high level code only contains blocks and control flow statements" << endl;
-		cerr << endl;
-		cerr << "\tThe remaining options all imply -d" << endl;
-		cerr << endl;
-		cerr << "\t-s show structuring info" << endl;
-		cerr << "\t-p show immediate post dominators" << endl; 
-		cerr << "\t-h show head of stucture enclosing each node" << endl;
-		cerr << "\t-r show the order of each node within the reverse graph" << endl;
-		cerr << endl;
-		exit(1);
-	}
+	if (argc != 1)
+		Usage(progname);
+	return *argv;
+}
+
+void Options::Usage(char* progname)
+{
+	cerr << "Usage: " << progname << " [-cgdsphr] [--option[=value] ...] Sparc_asm_file" << endl;
+	cerr << "\t-c generate the high level code" << endl;
+	cerr << "\t-g remove unecessary goto's from the generated code" << endl;
+	cerr << "\t-d generate the graphviz output" << endl;
+	cerr << endl;
+	cerr << "\tThe following option implies -c" << endl;
+	cerr << endl;
+	cerr << "\t-b high level code only contains blocks and control flow statements" << endl;
+	cerr << endl;
+	cerr << "\tThe remaining options all imply -d" << endl;
+	cerr << endl;
+	cerr << "\t-s show structuring info" << endl;
+	cerr << "\t-p show immediate post dominators" << endl; 
+	cerr << "\t-h show head of stucture enclosing each node" << endl;
+	cerr << "\t-r show the order of each node within the reverse graph" << endl;
+	cerr << endl;
+	cerr << "\tLong options:" << endl;
+	cerr << endl;
+	cerr << "\t--split[=n] split nodes of irreducible graphs, duplicating at most n" << endl;
+	cerr << "\t    instructions per procedure (default " << DEFAULT_SPLIT_BUDGET << ")" << endl;
+	cerr << "\t--structurer=parens|intervals structure the loops using parenthesis" << endl;
+	cerr << "\t    theory (the default) or the derived sequence of each graph" << endl;
+	cerr << "\t--diff also structure each graph with the other algorithm and report" << endl;
+	cerr << "\t    the time, memory and decisions of both for each procedure" << endl;
+	cerr << "\t--threads=n structure the independent regions of each graph with" << endl;
+	cerr << "\t    n threads (default 1)" << endl;
+	cerr << "\t--format=f[,f...] write the high level code in each of the formats" << endl;
+	cerr << "\t    hll (C like code, the default), json and bin (implies -c)" << endl;
+	cerr << "\t--dot=single|split|clusters write the graphviz output as one graph (the" << endl;
+	cerr << "\t    default), as one file per procedure written by the --threads threads" << endl;
+	cerr << "\t    or as one graph with a cluster per procedure (implies -d)" << endl;
+	cerr << "\t--dot-proc=name only put the named procedure in the graphviz output" << endl;
+	cerr << "\t--dot-min=n only put procedures of at least n nodes in the graphviz" << endl;
+	cerr << "\t    output" << endl;
+	cerr << "\t--dot-depth=n show each loop, conditional and case nested more than n" << endl;
+	cerr << "\t    deep as one node with the number of nodes and regions within it" << endl;
+	cerr << "\t--export=f[,f...] write the graph and structuring of each procedure" << endl;
+	cerr << "\t    as it is structured in each of the forms csr (binary) and jsonl" << endl;
+	cerr << "\t--stats=json also write the stats, with the time and memory taken by" << endl;
+	cerr << "\t    each phase, to <file>.stats.json" << endl;
+	cerr << "\t--perf count the cycles, instructions, cache misses and branch misses" << endl;
+	cerr << "\t    of each phase and procedure with the hardware performance counters" << endl;
+	cerr << "\t--proc-stats=csv|jsonl write the size, statements generated and the time" << endl;
+	cerr << "\t    and memory of each phase of each procedure to <file>.procs.csv or" << endl;
+	cerr << "\t    <file>.procs.jsonl and display the slowest procedures" << endl;
+	cerr << "\t--proc-top=n display the n slowest procedures with --proc-stats" << endl;
+	cerr << "\t    (default " << DEFAULT_PROC_TOP << ")" << endl;
+	cerr << "\t--trace=file write the time taken by each phase, each step of" << endl;
+	cerr << "\t    structuring each procedure and each thread to file in the Chrome" << endl;
+	cerr << "\t    trace event format" << endl;
+	cerr << endl;
+	exit(1);
 }
 
@@ -14,6 +14,40 @@
 #ifndef _OPTIONS_
 #define _OPTIONS_
 
+// an enumerated type for the algorithms that can be used to structure the loops
+enum structurer {
+	Parens,				// parenthesis theory (the loop stamps of each node)
+	Intervals			// interval theory (the derived sequence of each graph)
+};
+
+// the formats the high level code can be written in. Any number of them can be chosen.
+enum codeFormat {
+	CFormat = 1,		// C like code (<file>.hll)
+	JSONFormat = 2,	// compact JSON (<file>.json)
+	BinFormat = 4		// binary (<file>.hlb)
+};
+
+// the forms the graphs and their structuring can be exported in. Any number of them
+// can be chosen.
+enum exportFormat {
+	CSRExport = 1,		// binary (<file>.csr)
+	JSONLExport = 2	// JSON Lines (<file>.jsonl)
+};
+
+// the ways the graphviz output can be laid out
+enum dotLayout {
+	DotSingle,			// one graph holding every procedure (<file>.dot)
+	DotSplit,			// one file per procedure (<file>.<procedure>.dot)
+	DotClusters			// one graph with a cluster per procedure (<file>.dot)
+};
+
+// the forms the metrics of each procedure can be written in
+enum procStatsFormat {
+	NoProcStats,		// not written
+	CSVProcStats,		// CSV table (<file>.procs.csv)
+	JSONLProcStats		// JSON Lines (<file>.procs.jsonl)
+};
+
 // define a structure to store the command line options
 class Options {
 public:
@@ -27,9 +61,55 @@ public:
 	bool			revOrder;		// show the order of this node within the reverse graph
 	bool			blocksOnly;		// the generated code only includes basic blocks and
 										// control flow statements
+	bool			splitNodes;		// split nodes until irreducible graphs are reducible
+	int			splitBudget;	// the number of instructions that may be duplicated
+										// in each procedure when splitting nodes
+	structurer	structAlg;		// the algorithm used to structure the loops
+	bool			diffStruct;		// also structure each graph with the other algorithm
+										// and report where the two differ
+	int			numThreads;		// the number of threads that structure the independent
+										// regions of a graph and write the graphviz files
+	int			codeFormats;	// the formats (codeFormat bits) the high level code is
+										// written in
+	dotLayout	dotMode;			// the layout of the graphviz output
+	char*			dotProc;			// the only procedure put in the graphviz output (NULL
+										// for all of them)
+	int			dotMinSize;		// the fewest nodes a procedure needs to be put in the
+										// graphviz output
+	int			dotDepth;		// the deepest regions shown node by node in the graphviz
+										// output. Each region nested deeper is shown as one
+										// node (-1 to show every node).
+	int			exportFormats;	// the forms (exportFormat bits) each graph is exported
+										// in as it is structured (0 for none)
+	procStatsFormat procStats;	// the form the metrics of each procedure are written
+										// in (when built with GETSTATS)
+	int			procTop;			// the number of slowest procedures to display with the
+										// metrics of each procedure
+	bool			perfCounters;	// count the hardware events of each phase and
+										// procedure (see Perf.h)
+	bool			statsJSON;		// also write the stats to <file>.stats.json (when built
+										// with GETSTATS)
+	char*			traceFile;		// the file the trace of the phases is written to (NULL
+										// for none, see Trace.h)
 
 	// extracts the command line arguments
 	char* InitArgs(int argc, char *argv[]);
+
+private:
+	// process a long argument of the form "name" or "name=value" (without the
+	// leading "--")
+	void LongArg(char* arg);
+
+	// return the codeFormat bits of a comma separated list of format names (0 if
+	// any name is not known)
+	int Formats(char* value);
+
+	// return the exportFormat bits of a comma separated list of form names (0 if any
+	// name is not known)
+	int Exports(char* value);
+
+	// print the usage message and exit
+	void Usage(char* progname);
 };
 
 #endif
@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 1997, Doug Simon
+ *
+ * See the file "LICENSE.TERMS" for information on usage and
+ * redistribution of this file, and for a DISCLAIMER OF ALL
+ * WARRANTIES.
+ *
+ */
+
+// File: Perf.cc
+// Author: Doug Simon
+// Purpose: implements the reading of the hardware performance counters
+
+#include "Perf.h"
+#include <string.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#endif
+
+char const* PerfEventName[NUM_PERF_EVENTS] = { "cycles", "instructions", "branches",
+	"branchMisses", "L1Misses", "LLCMisses" };
+
+static int perfFd[NUM_PERF_EVENTS] = { -1, -1, -1, -1, -1, -1 };	// the counter of
+																						// each event
+
+#ifdef __linux__
+// the type and configuration of each event as perf_event_open takes them
+static struct {
+	unsigned type;
+	unsigned long long config;
+} const perfConfig[NUM_PERF_EVENTS] = {
+	{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+	{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+	{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_INSTRUCTIONS },
+	{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+	{ PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+		(PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+	{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES }
+};
+#endif
+
+bool PerfOpen()
+{
+	bool any = false;
+
+#ifdef __linux__
+	for (int e = 0; e < NUM_PERF_EVENTS; e++)
+	{
+		struct perf_event_attr attr;
+		memset(&attr, 0, sizeof(attr));
+		attr.size = sizeof(attr);
+		attr.type = perfConfig[e].type;
+		attr.config = perfConfig[e].config;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		attr.inherit = 1;
+		attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+		// this process on any processor
+		perfFd[e] = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+		if (perfFd[e] >= 0)
+			any = true;
+	}
+#endif
+
+	return any;
+}
+
+bool PerfAvailable(int e)
+{
+	return perfFd[e] >= 0;
+}
+
+void PerfRead(long long counts[NUM_PERF_EVENTS])
+{
+	for (int e = 0; e < NUM_PERF_EVENTS; e++)
+	{
+		// the count, the time the counter was enabled and the time it was counting
+		unsigned long long value[3];
+
+		counts[e] = 0;
+		if (perfFd[e] < 0 || read(perfFd[e], value, sizeof(value)) != sizeof(value))
+			continue;
+		if (value[2] == value[1])
+			counts[e] = value[0];
+		else if (value[2] != 0)
+			counts[e] = (long long)((double)value[0] * value[1] / value[2]);
+	}
+}
@@ -0,0 +1,49 @@
+/*
+ * Copyright (C) 1997, Doug Simon
+ *
+ * See the file "LICENSE.TERMS" for information on usage and
+ * redistribution of this file, and for a DISCLAIMER OF ALL
+ * WARRANTIES.
+ *
+ */
+
+// File: Perf.h
+// Author: Doug Simon
+// Purpose: reads the hardware performance counters of the processor (with
+//	perf_event_open on Linux) so that the time taken by each phase can be put down to
+//	the instructions run, cache misses or branch misses. Each counter that can't be
+//	opened (on other systems, when the kernel doesn't allow it or when the processor
+//	doesn't give access to it, as in many containers and virtual machines) counts
+//	nothing and is reported as not available.
+
+#ifndef _PERF_
+#define _PERF_
+
+// the events counted
+enum perfEvent {
+	CyclesEvent,			// processor cycles
+	InstructionsEvent,	// instructions completed
+	BranchesEvent,			// branch instructions completed
+	BranchMissesEvent,	// branches mispredicted
+	L1MissesEvent,			// level 1 data cache read misses
+	LLCMissesEvent			// last level cache misses
+};
+
+#define NUM_PERF_EVENTS 6
+
+// the names of the events
+extern char const* PerfEventName[NUM_PERF_EVENTS];
+
+// open the counters of the tool, which also count the threads it starts from now
+// on. Returns false if none of them could be opened.
+bool PerfOpen();
+
+// is event e being counted?
+bool PerfAvailable(int e);
+
+// set counts to the number of each event since the counters were opened (0 for the
+// events not counted). When there are more events than counters the processor
+// counts them in turn and each count is scaled up for the time it wasn't counted.
+void PerfRead(long long counts[NUM_PERF_EVENTS]);
+
+#endif
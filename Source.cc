@@ -9,13 +9,18 @@
 
 #include <fstream.h>
 #include <stdlib.h>
+#include <string.h>
 #include "StringFunctions.h"
 #include "Source.h"
+#include "Trace.h"
 
 #ifdef GETSTATS
 #include "Stats.h"
 #endif
 
+#define PARSE_CHUNK_LINES 65536		// the number of lines in each span of the trace
+#define READ_CHUNK_SIZE 65536		// the initial size of the buffer a pipe is read into
+
 //*****************************************************************************
 //Unfortunately I need this struct and it's ordering function declared globally
 //as I cannot get qsort and bsearch to work on it when declared inside LabelArr
@@ -31,21 +36,10 @@ int cmp(const void* l1, const void* l2)
 
 
 //*******************************************************************************
-//We need an auxillary class to store an array of <label,instruction_index> pairs
+//Implementation of the auxillary class storing the <label,instruction_index> pairs
 //*******************************************************************************
-class LabelArr {
-public:
-	LabelArr(int s);		//constructor that allocates space for s elements
-	~LabelArr() { if (pos) delete[] lArr; }
-	void Add(char const* l, int idx);	//add the <l,idx> pair to the array
-	void Sort();			//sort the internal array for faster lookups
-	int Find(char const* l);		//find the index of the instruction at which l occurs
-private:
-	_label* lArr;
-	int pos;
-};
-
 LabelArr::LabelArr(int s) { lArr = new _label[s]; pos = 0; }
+LabelArr::~LabelArr() { if (pos) delete[] lArr; }
 void LabelArr::Add(char const* l, int idx) { lArr[pos].name = mystrdup(l); lArr[pos++].idx = idx; }
 void LabelArr::Sort() { qsort(lArr,pos,sizeof(_label),cmp); }
 int  LabelArr::Find(char const* l)
@@ -75,13 +69,23 @@ static bool IsLabel(char* line);
 //Implementation of the Source class begins here
 //**********************************************
 
+Source::~Source()
+{
+	if (text)
+		delete[] text;
+}
+
 void Source::Build(char *fname)
 {
 	ifstream inFile(fname);		//input file stream is initialised to the file denoted by fname
 	
 	char* line;		//line of source code
-	int size, lineSize;	//stores various sizes when needed
+	char* pos;		//the start of the next line
+	char* end;		//the end of the text
+	int size;		//stores various sizes when needed
 	int insIdx = 0;		//index into array of instructions
+	int chunkLines = 0;	//number of lines in the chunk being traced
+	double start = TraceBegin();	//the time the span being traced started at
 
 	//check to make sure file was opened properly
 	if (!inFile) {
@@ -89,9 +93,42 @@ void Source::Build(char *fname)
 		exit (1);
 	}
 
+	//read the whole file into one buffer. Each line is terminated where it is so
+	//that the instructions can point to their text rather than copy it.
+	inFile.seekg(0, ios::end);
+	size = inFile.tellg();
+	if (size >= 0)
+	{
+		inFile.seekg(0, ios::beg);
+		text = new char[size + 1];
+		inFile.read(text, size);
+		end = text + inFile.gcount();
+	}
+	else
+	{
+		//fname can't be seeked in (it's a pipe or a FIFO) so it's read until it
+		//ends, the buffer being doubled each time it fills
+		int len = 0;
+		inFile.clear();
+		size = READ_CHUNK_SIZE;
+		text = new char[size + 1];
+		while (inFile.read(text + len, size - len), (len += inFile.gcount()) == size)
+		{
+			char* tmp = new char[2 * size + 1];
+			memcpy(tmp, text, len);
+			delete[] text;
+			text = tmp;
+			size *= 2;
+		}
+		end = text + len;
+	}
+	*end = '\0';
+	inFile.close();
+	TraceEnd("read", NULL, start);
+
 	//the first line of fname will contain the number of instructions
 	//in the file. Use this to reallocate space for the array of instructions.
-	inFile >> size;
+	size = strtol(text, &pos, 10);
 	arr.Init(size, true);
 #ifdef GETSTATS
 	stats.numAsmIns = size;
@@ -99,21 +136,29 @@ void Source::Build(char *fname)
 
 	//the second line in fname will contain the number of labels
 	//in the file. Use this to allocate space for the array of labels.
-	inFile >> size;
+	size = strtol(pos, &pos, 10);
 	LabelArr labels(size);
 
 	//the third line in fname will tell us the maximum length of
-	//any line of input. Use this to allocate space for the string variable
-	//used to read in each line. 
-	inFile >> lineSize;
-	line = new char[lineSize];
+	//any line of input. It isn't needed now that the lines aren't copied.
+	strtol(pos, &pos, 10);
 	
 	//Ignore up to the beginning of the next line
-	inFile.ignore(lineSize,'\n');
+	pos = strchr(pos, '\n');
+	pos = (pos ? pos + 1 : end);
 
-	//process each line of the source file
-	while (inFile.getline(line,lineSize))
+	//process each line of the source file. The trace has a span for each chunk
+	//of PARSE_CHUNK_LINES lines.
+	start = TraceBegin();
+	while (pos < end)
 	{
+		line = pos;
+		pos = (char*)memchr(line, '\n', end - line);
+		if (pos)
+			*pos++ = '\0';
+		else
+			pos = end;
+
 		if (IsLabel(line))
 		{
 			//add an entry to the array of labels
@@ -124,9 +169,19 @@ void Source::Build(char *fname)
 		}
 		else //it's an instruction line
 			arr[insIdx++].InitString(line);
+
+		if (++chunkLines == PARSE_CHUNK_LINES)
+		{
+			TraceEnd("parse chunk", NULL, start);
+			start = TraceBegin();
+			chunkLines = 0;
+		}
 	}
+	if (chunkLines > 0)
+		TraceEnd("parse chunk", NULL, start);
 
 	//sort the array of labels
+	start = TraceBegin();
 	labels.Sort();
 
 	//iterate through the array of instructions, filling in the control
@@ -158,6 +213,7 @@ void Source::Build(char *fname)
 				arr[insIdx].AddJmpDest(refIns);
 			}
 	}	
+	TraceEnd("resolve labels", NULL, start);
 
 #ifdef TESTSOURCE
 	for (insIdx = 0; insIdx < arr.Size(); insIdx++)
@@ -189,8 +245,6 @@ void Source::Build(char *fname)
 		}
 		cerr<< endl;
 	}	
-
-	inFile.close();
 #endif
 }
 
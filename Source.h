@@ -25,13 +25,31 @@
 //Simplying typedefs
 typedef DynArr<Instruction> InsArr;
 
+//We need an auxillary class to store an array of <label,instruction_index> pairs
+struct _label;
+class LabelArr {
+public:
+	LabelArr(int s);		//constructor that allocates space for s elements
+	~LabelArr();
+	void Add(char const* l, int idx);	//add the <l,idx> pair to the array
+	void Sort();			//sort the internal array for faster lookups
+	int Find(char const* l);		//find the index of the instruction at which l occurs
+private:
+	_label* lArr;
+	int pos;
+};
+
 class Source {
 public:
+	Source() : text(NULL) {}
+	~Source();
+
 	void Build(char* fname);	//build the array of instructions from the file denoted by fname
 	int Size() const;						//number of instructions
 	Instruction &operator[](int i) const;	//return a reference to the i'th instruction
 private:
 	InsArr arr;
+	char* text;		//the text of the file. The instructions point into it.
 };
 
 #endif
@@ -9,11 +9,22 @@
 
 // File Stats.cpp
 // Author: Doug Simon
-// Purpose: implements the dtime function
+// Purpose: implements the dtime function, the timers of the phases and the JSON
+//	report of the stats
 
 #include "Stats.h"
+#include <stdlib.h>
+#include <time.h>
 #include <sys/time.h>
 #include <sys/resource.h>
+#include <fstream.h>
+#include "Graphs.h"
+#include "Options.h"
+#include "MemAdvise.h"
+#include "Trace.h"
+#include "StringFunctions.h"
+
+extern Options options;
 
 static struct rusage Rusage;
 
@@ -31,3 +42,208 @@ int dtime(double p[])
 
    return 0;
 }
+
+double WallTime()
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (double)t.tv_sec + (double)t.tv_nsec * 1.0e-09;
+}
+
+double CPUTime()
+{
+	struct timespec t;
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &t);
+	return (double)t.tv_sec + (double)t.tv_nsec * 1.0e-09;
+}
+
+//*********************************************************************
+// The phases of the tool
+//*********************************************************************
+char const* PhaseName[NUM_PHASES] = { "other", "parse", "BuildNodes", "DefineEdges",
+	"DefineCfgs", "SplitNodes", "SetTimeStamps", "DerivedSequences", "Classify",
+	"Structure", "export", "CodeGen", "Graphviz" };
+
+static toolPhase curPhase = OtherPhase;	// the phase that is running
+static double phaseWall = -1.0;				// the wall clock time it started at (-1
+													// until the first phase starts)
+static double phaseCPU;							// the processor time it started at
+static long long phasePerf[NUM_PERF_EVENTS];	// the events counted when it started
+
+void StartPhase(toolPhase p)
+{
+	double wall = WallTime();
+	double cpu = CPUTime();
+	long long perf[NUM_PERF_EVENTS];
+	PerfRead(perf);
+
+	if (phaseWall >= 0.0)
+	{
+		stats.phaseWall[curPhase] += wall - phaseWall;
+		stats.phaseCPU[curPhase] += cpu - phaseCPU;
+		for (int e = 0; e < NUM_PERF_EVENTS; e++)
+			stats.phasePerf[curPhase][e] += perf[e] - phasePerf[e];
+		TraceEnd(PhaseName[curPhase], NULL, phaseWall);
+	}
+	curPhase = p;
+	phaseWall = wall;
+	phaseCPU = cpu;
+	for (int e = 0; e < NUM_PERF_EVENTS; e++)
+		phasePerf[e] = perf[e];
+	SetMemPhase(p);
+}
+
+// display a rate, or n/a if the events it is derived from weren't counted
+static void DisplayRate(char const* name, long long count, int event, long long per,
+	int perEvent, double scale)
+{
+	cout << ", " << name << " = ";
+	if (PerfAvailable(event) && PerfAvailable(perEvent) && per != 0)
+		cout << (double)count * scale / per;
+	else
+		cout << "n/a";
+}
+
+void DisplayPhasePerf()
+{
+	bool any = false;
+	for (int e = 0; e < NUM_PERF_EVENTS; e++)
+		any = any || PerfAvailable(e);
+	if (!any)
+	{
+		cout << "\t hardware performance counters are not available" << endl;
+		return;
+	}
+
+	for (int p = 0; p < NUM_PHASES; p++)
+	{
+		long long const* perf = stats.phasePerf[p];
+		if (stats.phaseWall[p] == 0.0)
+			continue;
+		cout << "\t " << PhaseName[p] << ": cycles = " << perf[CyclesEvent] <<
+			", instructions = " << perf[InstructionsEvent];
+		DisplayRate("IPC", perf[InstructionsEvent], InstructionsEvent, perf[CyclesEvent],
+			CyclesEvent, 1.0);
+		DisplayRate("branch miss %", perf[BranchMissesEvent], BranchMissesEvent,
+			perf[BranchesEvent], BranchesEvent, 100.0);
+		DisplayRate("L1 misses per 1000 instructions", perf[L1MissesEvent], L1MissesEvent,
+			perf[InstructionsEvent], InstructionsEvent, 1000.0);
+		DisplayRate("LLC misses per 1000 instructions", perf[LLCMissesEvent], LLCMissesEvent,
+			perf[InstructionsEvent], InstructionsEvent, 1000.0);
+		cout << endl;
+	}
+}
+
+//*********************************************************************
+// The JSON report
+//*********************************************************************
+// the counters of the stats in the order they are reported
+static struct {
+	char const* name;
+	int Stats::* count;
+} const counters[] = {
+	{ "numAsmIns", &Stats::numAsmIns },
+	{ "numUnreachIns", &Stats::numUnreachIns },
+	{ "numGraphNodes", &Stats::numGraphNodes },
+	{ "numGraphEdges", &Stats::numGraphEdges },
+	{ "numGotos", &Stats::numGotos },
+	{ "numGotosRemoved", &Stats::numGotosRemoved },
+	{ "numLoops", &Stats::numLoops },
+	{ "num2ways", &Stats::num2ways },
+	{ "numNways", &Stats::numNways },
+	{ "numContBrks", &Stats::numContBrks },
+	{ "maxIndent", &Stats::maxIndent },
+	{ "numIntervals", &Stats::numIntervals },
+	{ "numDerGraphs", &Stats::numDerGraphs },
+	{ "derGraphsMem", &Stats::derGraphsMem },
+	{ "numSplitNodes", &Stats::numSplitNodes },
+	{ "numSplitIns", &Stats::numSplitIns },
+	{ "numSplitEntries", &Stats::numSplitEntries },
+	{ "numIrreducible", &Stats::numIrreducible },
+	{ "numRegions", &Stats::numRegions },
+	{ "numParRegions", &Stats::numParRegions },
+	{ "numParNodes", &Stats::numParNodes }
+};
+
+// the times of the stats in the order they are reported
+static struct {
+	char const* name;
+	double Stats::* time;
+} const times[] = {
+	{ "bldDerSeqTime", &Stats::bldDerSeqTime },
+	{ "splitTime", &Stats::splitTime },
+	{ "classifyTime", &Stats::classifyTime },
+	{ "pstTime", &Stats::pstTime },
+	{ "structTime", &Stats::structTime },
+	{ "codeGenTime", &Stats::codeGenTime }
+};
+
+void WriteStatsJSON(char const* fname, char const* input)
+// The report is
+//	{"input":file,"structurer":name,"threads":n,
+//	 "counters":{name:n,...},			the counters of Stats
+//	 "times":{name:t,...},				the times of Stats (processor time in seconds)
+//	 "classes":[{"class":name,"count":n,"time":t},...],
+//	 "phases":[{"phase":name,"wall":t,"cpu":t,"bytes":n,"allocs":n,event:n...},...],
+//	 "memory":{"allocated":n,"freed":n,"inUse":n,"peakRSS":n,
+//				  "derSeqMemCost":n,"derSeqMemAlloc":n,"structMemCost":n,"structMemAlloc":n}}
+// with the memory in bytes except for peakRSS, which is in kilobytes. The hardware
+// events of each phase are given by name (see Perf.h) for those counted with --perf.
+{
+	ofstream out(fname);
+
+	//make sure file was successfully opened
+	if (!out)
+	{
+		cerr << "Error: could not open output file." << endl;
+		exit(1);
+	}
+
+	int i;
+	char* str = jsonstr(input);
+	out << "{\"input\":" << str;
+	delete[] str;
+	out << ",\"structurer\":\"" << (options.structAlg == Intervals ? "intervals" : "parens") << '"';
+	out << ",\"threads\":" << options.numThreads;
+
+	out << ",\n\"counters\":{";
+	for (i = 0; i < (int)(sizeof(counters) / sizeof(counters[0])); i++)
+		out << (i ? "," : "") << '"' << counters[i].name << "\":" << stats.*counters[i].count;
+	out << '}';
+
+	out << ",\n\"times\":{";
+	for (i = 0; i < (int)(sizeof(times) / sizeof(times[0])); i++)
+		out << (i ? "," : "") << '"' << times[i].name << "\":" << stats.*times[i].time;
+	out << '}';
+
+	out << ",\n\"classes\":[";
+	for (i = 0; i < NUM_GRAPH_CLASSES; i++)
+		out << (i ? "," : "") << "{\"class\":\"" << GraphClass2String((graphClass)i) <<
+			"\",\"count\":" << stats.numClass[i] << ",\"time\":" << stats.classTime[i] << '}';
+	out << ']';
+
+	out << ",\n\"phases\":[";
+	for (i = 0; i < NUM_PHASES; i++)
+	{
+		out << (i ? ",\n\t" : "\n\t") << "{\"phase\":\"" << PhaseName[i] << "\",\"wall\":" <<
+			stats.phaseWall[i] << ",\"cpu\":" << stats.phaseCPU[i] << ",\"bytes\":" <<
+			MemPhaseBytes((toolPhase)i) << ",\"allocs\":" << MemPhaseAllocs((toolPhase)i);
+		for (int e = 0; e < NUM_PERF_EVENTS; e++)
+			if (PerfAvailable(e))
+				out << ",\"" << PerfEventName[e] << "\":" << stats.phasePerf[i][e];
+		out << '}';
+	}
+	out << ']';
+
+	out << ",\n\"memory\":{\"allocated\":" << MemAllocated() << ",\"freed\":" << MemFreed() <<
+		",\"inUse\":" << MemInUse() << ",\"peakRSS\":" << MemPeakRSS() <<
+		",\"derSeqMemCost\":" << stats.derSeqMemCost << ",\"derSeqMemAlloc\":" <<
+		stats.derSeqMemAlloc << ",\"structMemCost\":" << stats.structMemCost <<
+		",\"structMemAlloc\":" << stats.structMemAlloc << "}}" << endl;
+
+	if (!out)
+	{
+		cerr << "Error: could not write to " << fname << "." << endl;
+		exit(1);
+	}
+}
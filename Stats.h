@@ -14,6 +14,8 @@
 #ifndef _STATS_
 #define _STATS_
 
+#include "Perf.h"
+
 /*****************************************************/
 /*  UNIX dtime(). This is the preferred UNIX timer.  */
 /*  Provided by: Markku Kolkka, mk59200@cc.tut.fi    */
@@ -21,48 +23,121 @@
 /*****************************************************/
 int dtime(double p[]);
 
+// return the wall clock time in seconds since some fixed point (that doesn't change
+// while the tool runs)
+double WallTime();
+
+// return the processor time used by all the threads of the tool in seconds
+double CPUTime();
+
+// the phases of the tool. The time taken by each phase is measured and the memory
+// allocated during it is attributed to it.
+enum toolPhase {
+	OtherPhase,				// any step that isn't one of the phases below
+	ParsePhase,				// reading the assembly source
+	BuildNodesPhase,		// building the basic blocks
+	DefineEdgesPhase,		// adding the edges of the graphs
+	DefineCfgsPhase,		// finding the graph of each procedure
+	SplitNodesPhase,		// splitting the nodes of irreducible graphs
+	SetTimeStampsPhase,	// the dfs numbering of the nodes
+	DerSeqPhase,			// building the derived sequences
+	ClassifyPhase,			// classifying the graphs
+	StructurePhase,		// structuring the graphs
+	ExportPhase,			// exporting the structured graphs (as part of structuring
+								// them, but timed on its own)
+	CodeGenPhase,			// generating the high level code
+	GraphvizPhase			// writing the graphviz output
+};
+
+#define NUM_PHASES 13
+
+// the names of the phases
+extern char const* PhaseName[NUM_PHASES];
+
+// end the current phase and start phase p. The tool starts in OtherPhase.
+void StartPhase(toolPhase p);
+
+// display the rates derived from the hardware events counted in each phase
+void DisplayPhasePerf();
+
+// write the stats, the time taken by each phase and the memory used to fname as JSON
+// (see WriteStatsJSON in Stats.cc for the fields)
+void WriteStatsJSON(char const* fname, char const* input);
+
+// the number of classes of cfg (see graphClass in Graphs.h)
+#define NUM_GRAPH_CLASSES 5
+
 struct Stats {
 	int numAsmIns;			// number of assembly instructions
 	int numGraphNodes;		// number of basic blocks/graph nodes
 	int numGraphEdges;		// number of graph edges
 	int numUnreachIns;		// number of unreachable nodes removed
 	int numGotos;				// number of gotos generated
+	int numGotosRemoved;		// number of gotos removed as they weren't needed
 	int numLoops;
 	int num2ways;
 	int numNways;
 	int numContBrks;		// number of continue's or break's from a loop
 	int maxIndent;			// maximum indentation level reached
 	
-#ifdef INTERVALS
 	int numIntervals;		// number of intervals in all derived graphs
 	int numDerGraphs;		// number of graphs in derived sequence
 	double bldDerSeqTime;	// time to build the derived sequence of graphs
 	int derGraphsMem;		// amount of memory taken up by the derived graphs
 
-	int derSeqMemCost;		// memory usage added by the derived sequences
-	int derSeqMemAlloc;		// memory allocated during building of derived
+	long derSeqMemCost;		// memory usage added by the derived sequences
+	long derSeqMemAlloc;	// memory allocated during building of derived
 							// sequences
-#endif
 
-	int structMemCost;		// memory usage added during structuring
-	int structMemAlloc;		// memory allocated during strucuring
+	int numSplitNodes;		// number of nodes duplicated by node splitting
+	int numSplitIns;		// number of instructions duplicated by node splitting
+	int numSplitEntries;	// number of entries into irreducible regions removed
+	int numIrreducible;		// number of graphs still irreducible after splitting
+	double splitTime;		// time to split the nodes
+
+	int numClass[NUM_GRAPH_CLASSES];		// number of cfg's in each class
+	double classTime[NUM_GRAPH_CLASSES];	// time to structure the cfg's in each class
+	double classifyTime;	// time to classify the cfg's
+
+	int numRegions;			// number of regions in the program structure trees
+	int numParRegions;		// number of regions structured by the threads
+	int numParNodes;		// number of nodes in these regions
+	double pstTime;			// time to build the program structure trees
+
+	long structMemCost;		// memory usage added during structuring
+	long structMemAlloc;	// memory allocated during strucuring
 	double structTime;		// time to do the structuring
 	double codeGenTime;		// time to generate the code
 
+	double phaseWall[NUM_PHASES];	// wall clock time taken by each phase
+	double phaseCPU[NUM_PHASES];	// processor time taken by each phase (by all the
+									// threads)
+	long long phasePerf[NUM_PHASES][NUM_PERF_EVENTS];	// the hardware events counted
+									// in each phase (with --perf)
+
 	//constructor function just sets everything to zero
 	Stats() {
 		numAsmIns = numGraphNodes = numGraphEdges = 
-		numUnreachIns = numGotos = numLoops =
+		numUnreachIns = numGotos = numGotosRemoved = numLoops =
 		num2ways = numNways = numContBrks = maxIndent =
-#ifdef INTERVALS
-		numIntervals = 
+		numIntervals = numDerGraphs = derGraphsMem =
 		derSeqMemCost = derSeqMemAlloc =
-#endif
+		numSplitNodes = numSplitIns = numSplitEntries = numIrreducible =
+		numRegions = numParRegions = numParNodes =
 		structMemCost = structMemAlloc = 0;
-		structTime = codeGenTime =
-#ifdef INTERVALS
-		bldDerSeqTime =
-#endif
+		for (int i = 0; i < NUM_GRAPH_CLASSES; i++)
+		{
+			numClass[i] = 0;
+			classTime[i] = 0.0;
+		}
+		for (int i = 0; i < NUM_PHASES; i++)
+		{
+			phaseWall[i] = phaseCPU[i] = 0.0;
+			for (int e = 0; e < NUM_PERF_EVENTS; e++)
+				phasePerf[i][e] = 0;
+		}
+		structTime = codeGenTime = splitTime = classifyTime =
+		bldDerSeqTime = pstTime =
 		0.0;
 	}
 };
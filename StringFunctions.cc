@@ -53,3 +53,42 @@ char* mystrdup (char const* str)
 	strcpy(retStr,str);
 	return retStr;
 }
+
+int jsonescape(char const* str, char* buf)
+{
+	static char const hex[] = "0123456789abcdef";
+	char* pos = buf;
+
+	*pos++ = '"';
+	for (char const* p = str; *p; p++)
+		if (*p == '"' || *p == '\\')
+		{
+			*pos++ = '\\';
+			*pos++ = *p;
+		}
+		else if (*p == '\t')
+		{
+			*pos++ = '\\';
+			*pos++ = 't';
+		}
+		else if ((unsigned char)*p < ' ')
+		{
+			// any other control character is given by its code
+			memcpy(pos, "\\u00", 4);
+			pos[4] = hex[*p >> 4];
+			pos[5] = hex[*p & 0xf];
+			pos += 6;
+		}
+		else
+			*pos++ = *p;
+	*pos++ = '"';
+
+	return pos - buf;
+}
+
+char* jsonstr(char const* str)
+{
+	char* retStr = new char[JSON_STR_MAX(strlen(str)) + 1];
+	retStr[jsonescape(str, retStr)] = '\0';
+	return retStr;
+}
@@ -27,4 +27,15 @@ char* digits(char const* str);
 // our own version of the strdup function. Required to make sure the 
 // memory stats gathered are correct.
 char* mystrdup(char const* str);
+
+// the most characters a string of len characters takes as a JSON string
+#define JSON_STR_MAX(len) (6 * (len) + 2)
+
+// write str to buf as a JSON string, in quotes and with its quotes, backslashes and
+// control characters escaped, and return the number of characters written. buf must
+// have room for JSON_STR_MAX(strlen(str)) characters and isn't null terminated.
+int jsonescape(char const* str, char* buf);
+
+// return str as a (null terminated) JSON string
+char* jsonstr(char const* str);
 #endif
@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 1997, Doug Simon
+ *
+ * See the file "LICENSE.TERMS" for information on usage and
+ * redistribution of this file, and for a DISCLAIMER OF ALL
+ * WARRANTIES.
+ *
+ */
+
+// File: Trace.cc
+// Author: Doug Simon
+// Purpose: implements the trace of the run. The spans of all the threads are collected
+//	in one buffer under a lock and written out in large blocks.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <iostream.h>
+#include "Trace.h"
+#include "HLLEmitter.h"
+#include "StringFunctions.h"
+
+bool tracing = false;
+
+static HLLEmitter* trace;		// the spans waiting to be written
+static int traceFd;				// the file of the trace
+static char* traceName;			// the name of the file
+static double traceStart;		// the time the trace started at
+static bool needComma;			// does the next span follow another?
+static pthread_mutex_t traceLock = PTHREAD_MUTEX_INITIALIZER;
+static int numTids = 0;			// the number of threads given an id
+static __thread int tid;		// the id of the calling thread (0 until it has one)
+
+// write out the spans collected so far
+static void Flush()
+{
+	if (!trace->Flush(traceFd))
+	{
+		cerr << "Error: could not write to " << traceName << "." << endl;
+		exit(1);
+	}
+}
+
+void TraceOpen(char const* fname)
+{
+	traceName = mystrdup(fname);
+	traceFd = open(traceName, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+
+	//make sure file was successfully opened
+	if (traceFd < 0)
+	{
+		cerr << "Error: could not open output file." << endl;
+		exit(1);
+	}
+
+	trace = new HLLEmitter;
+	trace->Add("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+	traceStart = WallTime();
+	needComma = false;
+	tracing = true;
+}
+
+void TraceClose()
+{
+	tracing = false;
+	trace->Add("\n]}\n");
+	Flush();
+	close(traceFd);
+	delete trace;
+	delete[] traceName;
+}
+
+void TraceSpan(char const* name, char const* proc, double start)
+{
+	double end = WallTime();
+	if (start < traceStart)
+		start = traceStart;
+
+	// the times are in microseconds from the start of the trace
+	char times[64];
+	sprintf(times, "\"ts\":%.3f,\"dur\":%.3f", (start - traceStart) * 1.0e6,
+		(end - start) * 1.0e6);
+
+	pthread_mutex_lock(&traceLock);
+	if (tid == 0)
+		tid = ++numTids;
+
+	trace->Add(needComma ? ",\n{\"name\":\"" : "\n{\"name\":\"");
+	trace->Add(name);
+	trace->Add("\",\"ph\":\"X\",");
+	trace->Add(times);
+	trace->Add(",\"pid\":1,\"tid\":");
+	trace->AddInt(tid);
+	if (proc)
+	{
+		trace->Add(",\"args\":{\"proc\":");
+		trace->AddJSONString(proc);
+		trace->Add('}');
+	}
+	trace->Add('}');
+	needComma = true;
+
+	if (trace->Size() >= EMIT_FLUSH_SIZE)
+		Flush();
+	pthread_mutex_unlock(&traceLock);
+}
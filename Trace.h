@@ -0,0 +1,49 @@
+/*
+ * Copyright (C) 1997, Doug Simon
+ *
+ * See the file "LICENSE.TERMS" for information on usage and
+ * redistribution of this file, and for a DISCLAIMER OF ALL
+ * WARRANTIES.
+ *
+ */
+
+// File: Trace.h
+// Author: Doug Simon
+// Purpose: writes a timeline of the run in the trace event format read by Chrome
+//	(chrome://tracing) and Perfetto. Each phase of the tool and each step of each
+//	procedure is a span on the thread that ran it. A span is timed with
+//
+//		double start = TraceBegin();
+//		...
+//		TraceEnd("name", procName, start);
+//
+//	which only reads the clock when the trace is being written.
+
+#ifndef _TRACE_
+#define _TRACE_
+
+#include "Stats.h"
+
+extern bool tracing;		// is the trace being written?
+
+// start writing the trace to fname
+void TraceOpen(char const* fname);
+
+// finish the trace and close its file
+void TraceClose();
+
+// record a span of the calling thread named name that started at start (as given by
+// WallTime) and ends now. proc is the procedure it was for (NULL if none).
+void TraceSpan(char const* name, char const* proc, double start);
+
+// return the time a span starts at (0 if the trace isn't being written)
+inline double TraceBegin() { return tracing ? WallTime() : 0.0; }
+
+// end a span started at start
+inline void TraceEnd(char const* name, char const* proc, double start)
+{
+	if (tracing)
+		TraceSpan(name, proc, start);
+}
+
+#endif
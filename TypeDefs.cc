@@ -67,7 +67,8 @@ char const* Type2String(iType t) { return _opcodeStrings[t]; }
 
 iType String2Type(const char* opString)
 {
-	const int NumOpcodes = 236 + 1;
+	// "invalid" is last and out of order so it is left out of the search
+	const int NumOpcodes = 236;
 	char** result = static_cast<char**>(bsearch(&opString,_opcodeStrings,NumOpcodes,sizeof(_opcodeStrings[0]),comp_fn));
 	assert(result);
 	//return static_cast<iType>((static_cast<int>(result) - static_cast<int>(_opcodeStrings)) / sizeof(char**));
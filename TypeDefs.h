@@ -26,7 +26,6 @@ enum bbType {
 	nway,	     //  jump on a register value
 	ret,
 	fall,        // a fall through basic block
-	intNode,     // this is actually an interval node
 	other
 };
 
@@ -0,0 +1,39 @@
+30
+6
+20
+main:
+	save %sp,-112,%sp
+	mov 0,%o0
+.LL2:
+	cmp %o0,10
+	bge .LL9
+	nop
+.LL3:
+	cmp %o1,0
+	be .LL6
+	nop
+	add %o1,1,%o1
+	cmp %o1,5
+	be .LL9
+	nop
+	cmp %o1,7
+	bg .LL8
+	nop
+	b .LL3
+	nop
+.LL6:
+	add %o2,1,%o2
+	cmp %o2,3
+	bne .LL2
+	nop
+.LL8:
+	add %o0,1,%o0
+	cmp %o3,0
+	be .LL9
+	nop
+	b .LL2
+	add %o0,2,%o0
+.LL9:
+	mov %o0,%i0
+	ret
+	restore
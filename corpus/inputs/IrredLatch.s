@@ -0,0 +1,20 @@
+11
+6
+16
+main:
+	bg .LL1
+	nop
+.LL2:
+	jmp .LL3 .LL4
+	nop
+.LL3:
+	b .LL5
+	nop
+.LL4:
+	nop
+.LL5:
+.LL1:
+	bge .LL2
+	nop
+	ret
+	restore
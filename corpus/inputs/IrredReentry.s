@@ -0,0 +1,17 @@
+9
+5
+16
+main:
+	bg .LL1
+	nop
+.LL2:
+	nop
+.LL3:
+	nop
+.LL1:
+	add %o0,0,%o3
+.LL4:
+	bne .LL2
+	nop
+	ret
+	restore
@@ -0,0 +1,17 @@
+12
+2
+21
+main:
+	save %sp,-112,%sp
+	xorcc %i0,%i1,%o0
+	be .LL1
+	nop
+	xor %o0,1,%o0
+	xnorcc %o0,%i1,%o1
+	bne .LL1
+	nop
+	wr %o1,%y
+.LL1:
+	mov %o0,%i0
+	ret
+	restore
@@ -0,0 +1,47 @@
+36
+8
+20
+main:
+	save %sp,-112,%sp
+	mov 0,%o0
+.LL2:
+	cmp %o0,10
+	bl .LL3
+	nop
+	b .LL9
+	nop
+.LL3:
+	cmp %o1,0
+	bne .LL4
+	nop
+	b .LL6
+	nop
+.LL4:
+	add %o1,1,%o1
+	cmp %o1,7
+	ble .LL5
+	nop
+	b .LL8
+	nop
+.LL5:
+	cmp %o1,5
+	bne .LL3
+	nop
+	b .LL9
+	nop
+.LL6:
+	add %o2,1,%o2
+	cmp %o2,3
+	be .LL8
+	nop
+	b .LL2
+	nop
+.LL8:
+	add %o0,1,%o0
+	cmp %o3,0
+	bne .LL2
+	add %o0,2,%o0
+.LL9:
+	mov %o0,%i0
+	ret
+	restore